@@ -1,28 +1,163 @@
 #include "button.h"
+#include "soc/soc.h"
+#include "soc/gpio_reg.h"
 
 static const char* TAG = "BUTTONS";
 
-static QueueHandle_t button_event_queue = NULL;
-static button_config_t button_configs[MAX_BUTTONS];
+// Estado de cada botao. O ISR de borda so reinicia o timer de debounce; a maquina de
+// estados roda no callback do timer, que tambem mede a pressao longa.
+typedef struct {
+    button_config_t config;
+    esp_timer_handle_t timer;
+    volatile bool debouncing;
+    bool pressed;                   // estado estavel depois do debounce
+    bool long_sent;
+    uint8_t clicks;                 // 1: clique curto esperando o segundo; 2: duplo ja enviado
+    int64_t press_us;
+    int64_t release_us;
+} button_state_t;
+
+// Todos os eventos saem da tarefa do esp_timer, o unico produtor da fila
+static button_event_data_t button_event_storage[BUTTON_EVENT_RING_LENGTH];
+static ring_t button_events;
+static bool button_events_ready = false;
+static button_state_t button_states[MAX_BUTTONS];
 static int num_buttons_configured = 0;
 static bool buttons_initialized = false;
+static bool isr_service_installed = false;
+
+// Varredura: bit n de cada mascara e o GPIO n. O par cnt1:cnt0 e um contador de 2 bits
+// por pino, guardado na vertical para que uma operacao trate os 64 pinos juntos.
+static esp_timer_handle_t button_poll_timer = NULL;
+static uint64_t button_poll_mask = 0;
+static uint64_t button_poll_active_low = 0;
+static uint64_t button_poll_cnt0 = 0;
+static uint64_t button_poll_cnt1 = 0;
+static volatile uint64_t button_poll_state = 0;     // 1 = apertado, ja filtrado
+static button_poll_callback_t button_poll_callback = NULL;
 
 static void IRAM_ATTR button_isr_handler(void* arg) {
-    gpio_num_t gpio_num = (gpio_num_t)(int)arg;
+    button_state_t* button = (button_state_t*)arg;
+
+    // Cada repique empurra o prazo; o nivel so e lido quando o pino fica parado
+    button->debouncing = true;
+    esp_timer_stop(button->timer);
+    esp_timer_start_once(button->timer, button->config.debounce_time_ms * 1000ULL);
+}
+
+static void button_post(gpio_num_t gpio_num, button_event_t event) {
     button_event_data_t event_data = {
         .gpio_num = gpio_num,
-        .event = BUTTON_EVENT_PRESSED,
+        .event = event,
         .timestamp = esp_timer_get_time() / 1000
     };
-    
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-    xQueueSendFromISR(button_event_queue, &event_data, &xHigherPriorityTaskWoken);
-    
-    if (xHigherPriorityTaskWoken) {
-        portYIELD_FROM_ISR();
+
+    if (button_events_ready) {
+        ring_push(&button_events, &event_data);
+    }
+}
+
+static void button_emit(button_state_t* button, button_event_t event) {
+    button_post(button->config.gpio_num, event);
+    if (button->config.callback != NULL) {
+        button->config.callback(button->config.gpio_num, event);
+    }
+}
+
+static void button_timer_callback(void* arg) {
+    button_state_t* button = (button_state_t*)arg;
+    int64_t now = esp_timer_get_time();
+
+    if (!button->debouncing) {
+        // Prazo da pressao longa
+        if (button->pressed && !button->long_sent) {
+            button->long_sent = true;
+            button_emit(button, BUTTON_EVENT_LONG_PRESS);
+        }
+        return;
+    }
+    button->debouncing = false;
+
+    bool pressed = gpio_get_level(button->config.gpio_num) == (button->config.active_low ? 0 : 1);
+    if (pressed && !button->pressed) {
+        button->pressed = true;
+        button->long_sent = false;
+        button->press_us = now;
+        button_emit(button, BUTTON_EVENT_PRESSED);
+
+        if (button->clicks == 1 && now - button->release_us <= BUTTON_DOUBLE_CLICK_TIME_MS * 1000LL) {
+            button->clicks = 2;
+            button_emit(button, BUTTON_EVENT_DOUBLE_CLICK);
+        } else {
+            button->clicks = 0;
+        }
+    } else if (!pressed && button->pressed) {
+        button->pressed = false;
+        button->release_us = now;
+        button->clicks = (button->long_sent || button->clicks == 2) ? 0 : 1;
+        button_emit(button, BUTTON_EVENT_RELEASED);
+    }
+
+    // Um repique no meio da pressao cancelou o prazo da pressao longa; arma o que falta
+    if (button->pressed && !button->long_sent) {
+        int64_t remaining = button->press_us + button->config.long_press_time_ms * 1000LL - now;
+        esp_timer_start_once(button->timer, remaining > 0 ? remaining : 1);
     }
 }
 
+static esp_err_t button_engine_init(void) {
+    if (!button_events_ready) {
+        ring_init(&button_events, button_event_storage, sizeof(button_event_data_t), BUTTON_EVENT_RING_LENGTH);
+        button_events_ready = true;
+    }
+
+    if (!isr_service_installed) {
+        esp_err_t ret = gpio_install_isr_service(0);
+        if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+            ESP_LOGE(TAG, "Failed to install ISR service: %s", esp_err_to_name(ret));
+            return ret;
+        }
+        isr_service_installed = true;
+    }
+    return ESP_OK;
+}
+
+// O GPIO ja precisa estar configurado com interrupcao nas duas bordas
+static esp_err_t button_engine_add(const button_config_t* config) {
+    if (num_buttons_configured >= MAX_BUTTONS) {
+        ESP_LOGE(TAG, "Maximum number of buttons reached");
+        return ESP_ERR_NO_MEM;
+    }
+
+    button_state_t* button = &button_states[num_buttons_configured];
+    *button = (button_state_t){
+        .config = *config,
+    };
+    button->pressed = gpio_get_level(config->gpio_num) == (config->active_low ? 0 : 1);
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = button_timer_callback,
+        .arg = button,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "button"
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &button->timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create timer for GPIO %d: %s", config->gpio_num, esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = gpio_isr_handler_add(config->gpio_num, button_isr_handler, button);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add ISR handler for GPIO %d: %s", config->gpio_num, esp_err_to_name(ret));
+        esp_timer_delete(button->timer);
+        return ret;
+    }
+
+    num_buttons_configured++;
+    return ESP_OK;
+}
+
 esp_err_t init_buttons(gpio_config_t* gpio_button_config) {
     if (gpio_button_config == NULL) {
         ESP_LOGE(TAG, "GPIO config is NULL");
@@ -41,41 +176,39 @@ esp_err_t init_buttons(gpio_config_t* gpio_button_config) {
     return ESP_OK;
 }
 
+// Os botoes da mascara usam os tempos padrao; pull-up ligado indica botao ativo em 0
 esp_err_t init_buttons_isr(gpio_config_t* gpio_button_config, button_isr_callback_t isr_callback) {
     if (gpio_button_config == NULL) {
         ESP_LOGE(TAG, "GPIO config is NULL");
         return ESP_ERR_INVALID_ARG;
     }
     
-    if (button_event_queue == NULL) {
-        button_event_queue = xQueueCreate(10, sizeof(button_event_data_t));
-        if (button_event_queue == NULL) {
-            ESP_LOGE(TAG, "Failed to create event queue");
-            return ESP_ERR_NO_MEM;
-        }
-    }
-    
-    static bool isr_service_installed = false;
-    if (!isr_service_installed) {
-        esp_err_t ret = gpio_install_isr_service(0);
-        if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
-            ESP_LOGE(TAG, "Failed to install ISR service: %s", esp_err_to_name(ret));
-            return ret;
-        }
-        isr_service_installed = true;
+    esp_err_t ret = button_engine_init();
+    if (ret != ESP_OK) {
+        return ret;
     }
     
-    esp_err_t ret = gpio_config(gpio_button_config);
+    // Soltar o botao tambem gera evento, entao as duas bordas interrompem
+    gpio_config_t io_conf = *gpio_button_config;
+    io_conf.intr_type = GPIO_INTR_ANYEDGE;
+    ret = gpio_config(&io_conf);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to configure GPIO: %s", esp_err_to_name(ret));
         return ret;
     }
     
     for (int i = 0; i < 64; i++) {
-        if (gpio_button_config->pin_bit_mask & (1ULL << i)) {
-            ret = gpio_isr_handler_add(i, button_isr_handler, (void*)i);
+        if (io_conf.pin_bit_mask & (1ULL << i)) {
+            const button_config_t config = {
+                .gpio_num = i,
+                .pull_mode = io_conf.pull_up_en == GPIO_PULLUP_ENABLE ? GPIO_PULLUP_ONLY : GPIO_PULLDOWN_ONLY,
+                .active_low = io_conf.pull_up_en == GPIO_PULLUP_ENABLE,
+                .debounce_time_ms = BUTTON_DEBOUNCE_TIME_MS,
+                .long_press_time_ms = BUTTON_LONG_PRESS_TIME_MS,
+                .callback = isr_callback
+            };
+            ret = button_engine_add(&config);
             if (ret != ESP_OK) {
-                ESP_LOGE(TAG, "Failed to add ISR handler for GPIO %d: %s", i, esp_err_to_name(ret));
                 return ret;
             }
         }
@@ -92,9 +225,9 @@ esp_err_t button_config_advanced(button_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    if (num_buttons_configured >= MAX_BUTTONS) {
-        ESP_LOGE(TAG, "Maximum number of buttons reached");
-        return ESP_ERR_NO_MEM;
+    esp_err_t ret = button_engine_init();
+    if (ret != ESP_OK) {
+        return ret;
     }
     
     gpio_config_t gpio_conf = {
@@ -105,14 +238,18 @@ esp_err_t button_config_advanced(button_config_t* config) {
         .intr_type = GPIO_INTR_ANYEDGE
     };
     
-    esp_err_t ret = gpio_config(&gpio_conf);
+    ret = gpio_config(&gpio_conf);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to configure GPIO %d: %s", config->gpio_num, esp_err_to_name(ret));
         return ret;
     }
     
-    button_configs[num_buttons_configured] = *config;
-    num_buttons_configured++;
+    ret = button_engine_add(config);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    buttons_initialized = true;
     
     ESP_LOGI(TAG, "Button GPIO %d configured successfully", config->gpio_num);
     return ESP_OK;
@@ -127,27 +264,28 @@ int button_read(gpio_num_t gpio_num) {
     return gpio_get_level(gpio_num);
 }
 
+// Devolve o nivel eletrico filtrado: pelo modo por varredura, pela maquina de estados do
+// botao ou, sem nenhum dos dois, a leitura direta do pino
 int button_read_debounced(gpio_num_t gpio_num) {
-    static uint32_t last_read_time[64] = {0};
-    static int last_state[64] = {-1};
-    
     if (!buttons_initialized) {
         ESP_LOGW(TAG, "Buttons not initialized");
         return -1;
     }
     
-    uint32_t current_time = esp_timer_get_time() / 1000; 
-    int current_state = gpio_get_level(gpio_num);
+    uint64_t bit = 1ULL << gpio_num;
+    if (button_poll_timer != NULL && (button_poll_mask & bit)) {
+        bool pressed = (button_poll_state & bit) != 0;
+        bool active_low = (button_poll_active_low & bit) != 0;
+        return pressed != active_low;
+    }
     
-    if (current_state != last_state[gpio_num] && 
-        (current_time - last_read_time[gpio_num]) > BUTTON_DEBOUNCE_TIME_MS) {
-        
-        last_state[gpio_num] = current_state;
-        last_read_time[gpio_num] = current_time;
-        return current_state;
+    for (int i = 0; i < num_buttons_configured; i++) {
+        if (button_states[i].config.gpio_num == gpio_num) {
+            return button_states[i].pressed != button_states[i].config.active_low;
+        }
     }
     
-    return last_state[gpio_num];
+    return gpio_get_level(gpio_num);
 }
 
 esp_err_t button_wait_event(button_event_data_t* event_data, uint32_t timeout_ms) {
@@ -155,14 +293,14 @@ esp_err_t button_wait_event(button_event_data_t* event_data, uint32_t timeout_ms
         return ESP_ERR_INVALID_ARG;
     }
     
-    if (button_event_queue == NULL) {
+    if (!button_events_ready) {
         ESP_LOGE(TAG, "Event queue not initialized");
         return ESP_ERR_INVALID_STATE;
     }
     
     TickType_t timeout_ticks = (timeout_ms == UINT32_MAX) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
     
-    if (xQueueReceive(button_event_queue, event_data, timeout_ticks) == pdTRUE) {
+    if (ring_wait(&button_events, event_data, timeout_ticks)) {
         return ESP_OK;
     }
     
@@ -173,10 +311,10 @@ esp_err_t button_get_event(button_event_data_t* event_data) {
     if (event_data == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
-    if (button_event_queue == NULL) {
+    if (!button_events_ready) {
         return ESP_ERR_INVALID_STATE;
     }
-    if (xQueueReceive(button_event_queue, event_data, 0) == pdTRUE) {
+    if (ring_pop(&button_events, event_data)) {
         return ESP_OK;
     }
     return ESP_ERR_NOT_FOUND;
@@ -195,22 +333,28 @@ esp_err_t button_enable(gpio_num_t gpio_num, bool enable) {
 }
 
 esp_err_t button_clear_events(void) {
-    if (button_event_queue == NULL) {
+    if (!button_events_ready) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    xQueueReset(button_event_queue);
+    ring_reset(&button_events);
     return ESP_OK;
 }
 
+// Eventos perdidos com a fila cheia e a maior ocupacao desde o boot
+void button_get_event_stats(ring_stats_t* out) {
+    ring_get_stats(&button_events, out);
+}
+
 esp_err_t buttons_deinit(void) {
     for (int i = 0; i < num_buttons_configured; i++) {
-        gpio_isr_handler_remove(button_configs[i].gpio_num);
+        gpio_isr_handler_remove(button_states[i].config.gpio_num);
+        esp_timer_stop(button_states[i].timer);
+        esp_timer_delete(button_states[i].timer);
     }
     
-    if (button_event_queue != NULL) {
-        vQueueDelete(button_event_queue);
-        button_event_queue = NULL;
+    if (button_poll_timer != NULL) {
+        button_poll_stop();
     }
     
     num_buttons_configured = 0;
@@ -248,4 +392,113 @@ esp_err_t button_init_pulldown(gpio_num_t gpio_num, button_isr_callback_t callba
     } else {
         return init_buttons(&gpio_conf);
     }
-}
\ No newline at end of file
+}
+
+// Uma leitura por banco de GPIO pega todos os pinos no mesmo instante
+static inline uint64_t button_poll_read_pins(void) {
+    return (uint64_t)REG_READ(GPIO_IN_REG) | ((uint64_t)REG_READ(GPIO_IN1_REG) << 32);
+}
+
+// Contador vertical: cada pino cujo nivel difere do estado filtrado conta uma leitura;
+// na quarta seguida o estado vira. Uma leitura igual ao estado zera o contador do pino.
+static void button_poll_callback_timer(void* arg) {
+    uint64_t sample = (button_poll_read_pins() ^ button_poll_active_low) & button_poll_mask;
+    uint64_t state = button_poll_state;
+    uint64_t delta = sample ^ state;
+
+    button_poll_cnt1 = (button_poll_cnt1 ^ button_poll_cnt0) & delta;
+    button_poll_cnt0 = ~button_poll_cnt0 & delta;
+    uint64_t toggle = delta & ~(button_poll_cnt0 | button_poll_cnt1);
+    if (toggle == 0) {
+        return;
+    }
+
+    state ^= toggle;
+    button_poll_state = state;
+    uint64_t pressed = toggle & state;
+    uint64_t released = toggle & ~state;
+
+    if (button_poll_callback != NULL) {
+        button_poll_callback(pressed, released);
+    }
+    while (toggle != 0) {
+        int gpio_num = __builtin_ctzll(toggle);
+        toggle &= toggle - 1;
+        button_post(gpio_num, (pressed >> gpio_num) & 1 ? BUTTON_EVENT_PRESSED : BUTTON_EVENT_RELEASED);
+    }
+}
+
+// Le ate 64 entradas sem interrupcao, no periodo BUTTON_POLL_PERIOD_MS. Os pinos de
+// pin_mask nao devem ser registrados tambem no modo por interrupcao.
+esp_err_t button_poll_start(uint64_t pin_mask, uint64_t active_low_mask, button_poll_callback_t callback) {
+    if (pin_mask == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (button_poll_timer != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    esp_err_t ret = button_engine_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    gpio_config_t io_conf = {
+        .pin_bit_mask = pin_mask & active_low_mask,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE
+    };
+    if (io_conf.pin_bit_mask != 0 && (ret = gpio_config(&io_conf)) != ESP_OK) {
+        return ret;
+    }
+    io_conf.pin_bit_mask = pin_mask & ~active_low_mask;
+    io_conf.pull_up_en = GPIO_PULLUP_DISABLE;
+    io_conf.pull_down_en = GPIO_PULLDOWN_ENABLE;
+    if (io_conf.pin_bit_mask != 0 && (ret = gpio_config(&io_conf)) != ESP_OK) {
+        return ret;
+    }
+    
+    // Comeca do nivel atual, sem gerar bordas para botoes ja apertados no boot
+    button_poll_mask = pin_mask;
+    button_poll_active_low = active_low_mask;
+    button_poll_cnt0 = 0;
+    button_poll_cnt1 = 0;
+    button_poll_state = (button_poll_read_pins() ^ active_low_mask) & pin_mask;
+    button_poll_callback = callback;
+    
+    const esp_timer_create_args_t timer_args = {
+        .callback = button_poll_callback_timer,
+        .name = "button_poll"
+    };
+    ret = esp_timer_create(&timer_args, &button_poll_timer);
+    if (ret == ESP_OK) {
+        ret = esp_timer_start_periodic(button_poll_timer, BUTTON_POLL_PERIOD_MS * 1000ULL);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start poll timer: %s", esp_err_to_name(ret));
+        button_poll_stop();
+        return ret;
+    }
+    
+    buttons_initialized = true;
+    ESP_LOGI(TAG, "Polling %d buttons every %d ms", __builtin_popcountll(pin_mask), BUTTON_POLL_PERIOD_MS);
+    return ESP_OK;
+}
+
+esp_err_t button_poll_stop(void) {
+    if (button_poll_timer == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    esp_timer_stop(button_poll_timer);
+    esp_timer_delete(button_poll_timer);
+    button_poll_timer = NULL;
+    return ESP_OK;
+}
+
+// Bit n em 1: GPIO n apertado, ja com a polaridade aplicada
+uint64_t button_poll_get_state(void) {
+    return button_poll_state;
+}
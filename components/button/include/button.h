@@ -4,13 +4,18 @@
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
+#include "ring.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 
 #define MAX_BUTTONS                 8
 #define BUTTON_DEBOUNCE_TIME_MS     50
 #define BUTTON_LONG_PRESS_TIME_MS   1000
+#define BUTTON_DOUBLE_CLICK_TIME_MS 300     // maior intervalo entre soltar e apertar de novo
+#define BUTTON_EVENT_RING_LENGTH    16      // potencia de dois
+
+// Modo por varredura: todos os pinos lidos de uma vez, debounce por contadores verticais
+#define BUTTON_POLL_PERIOD_MS       5       // 4 leituras iguais seguidas = 20 ms de debounce
 
 typedef enum {
     BUTTON_EVENT_PRESSED,
@@ -25,8 +30,12 @@ typedef struct {
     uint32_t timestamp;
 } button_event_data_t;
 
+// Apesar do nome, e chamada pela tarefa do esp_timer e nao dentro da interrupcao
 typedef void (*button_isr_callback_t)(gpio_num_t gpio_num, button_event_t event);
 
+// Bordas de uma varredura, com o bit n representando o GPIO n
+typedef void (*button_poll_callback_t)(uint64_t pressed_mask, uint64_t released_mask);
+
 typedef struct {
     gpio_num_t gpio_num;
     gpio_pull_mode_t pull_mode;
@@ -45,8 +54,12 @@ esp_err_t button_wait_event(button_event_data_t* event_data, uint32_t timeout_ms
 esp_err_t button_get_event(button_event_data_t* event_data);
 esp_err_t button_enable(gpio_num_t gpio_num, bool enable);
 esp_err_t button_clear_events(void);
+void button_get_event_stats(ring_stats_t* out);
 esp_err_t buttons_deinit(void);
 esp_err_t button_init_pullup(gpio_num_t gpio_num, button_isr_callback_t callback);
 esp_err_t button_init_pulldown(gpio_num_t gpio_num, button_isr_callback_t callback);
+esp_err_t button_poll_start(uint64_t pin_mask, uint64_t active_low_mask, button_poll_callback_t callback);
+esp_err_t button_poll_stop(void);
+uint64_t button_poll_get_state(void);
 
 #endif
\ No newline at end of file
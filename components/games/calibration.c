@@ -0,0 +1,47 @@
+#include "calibration.h"
+#include "sensor.h"
+#include "ssd1306.h"
+#include "buzzer.h"
+#include "driver/gpio.h"
+
+// Usa a calibracao salva na NVS se ela ainda vale para a temperatura atual.
+// Segurar os dois botoes ao entrar no jogo forca uma nova calibracao.
+static bool calibration_reuse_stored(void) {
+    if (gpio_get_level(40) == 0 && gpio_get_level(38) == 0) {
+        return false;
+    }
+
+    sensor_calibration_t cal;
+    return sensor_get_calibration(&cal) == ESP_OK;
+}
+
+// Tela unica de calibracao. O estimador de vies continua refinando durante o jogo,
+// entao basta uma medida curta para semear os offsets.
+bool calibration_quick_check(void) {
+    if (calibration_reuse_stored()) {
+        return true;
+    }
+
+    ssd1306_clear_buffer();
+    ssd1306_draw_string(15, 20, "CALIBRANDO...");
+    ssd1306_draw_string(10, 35, "MANTENHA PARADO");
+    ssd1306_update_display();
+
+    sensor_calibration_t cal;
+    bool calibrated = sensor_calibrate(&cal) == ESP_OK;
+
+    ssd1306_clear_buffer();
+    if (calibrated) {
+        ssd1306_draw_string(20, 20, "CALIBRADO!");
+        ssd1306_draw_string(10, 35, "INCLINE PARA");
+        ssd1306_draw_string(15, 50, "CONTROLAR");
+        play_tone(1200, 200);
+    } else {
+        ssd1306_draw_string(5, 20, "CALIBRACAO");
+        ssd1306_draw_string(20, 35, "FALHOU!");
+        play_tone(500, 500);
+    }
+    ssd1306_update_display();
+    vTaskDelay(500 / portTICK_PERIOD_MS);
+    return calibrated;
+}
@@ -6,9 +6,6 @@ static bool game_over = false;
 static Block blocks[MAX_BLOCKS];
 static float player_velocity = 0.0f;
 
-float accel_offset_x = 0;
-float accel_offset_y = 0;
-
 void reset_game() {
     player_x = 128 / 2;
     score = 0;
@@ -36,19 +33,17 @@ bool check_collision(Block *b) {
 }
 
 void control_player_with_gyro(void) {
-    mpu6050_data_t data;
+    sensor_sample_t sample;
     
-    bool data_ok = (mpu6050_read_all(&data) == ESP_OK);
+    bool data_ok = sensor_get_latest(&sample);
     
     if (data_ok) {
-        // Converter aceleração
-        float accel_x = ((float)data.accel_x / 16384.0f) - accel_offset_x;
-        float accel_y = ((float)data.accel_y / 16384.0f) - accel_offset_y;
+        int32_t accel_x = MPU6050_FLOAT_TO_Q16(sample.orientation.gravity_g[0] - sample.bias.accel_offset_g[0]);
+        int32_t accel_y = MPU6050_FLOAT_TO_Q16(sample.orientation.gravity_g[1] - sample.bias.accel_offset_g[1]);
         
-        // Converter giroscópio 
-        float gyro_x = (float)data.gyro_x / 131.0f;
+        float gyro_x = sample.gyro_dps[0];
         
-        float tilt_angle = atan2(accel_x, accel_y) * 180.0f / M_PI;
+        float tilt_angle = MPU6050_Q16_TO_FLOAT(mpu6050_atan2_deg_q16(accel_x, accel_y));
         
         const float tilt_dead_zone = 5.0f;
         if (fabs(tilt_angle) < tilt_dead_zone) {
@@ -64,11 +59,8 @@ void control_player_with_gyro(void) {
         float gyro_movement = gyro_x * 0.4f;
         float total_movement = tilt_movement + gyro_movement;
         
-        static float filtered_movement = 0.0f;
-        filtered_movement = filtered_movement * 0.6f + total_movement * 0.4f;
-        
-        static float target_velocity = 0.0f;
-        target_velocity = filtered_movement * 0.15f;
+        // A fusao ja suaviza a inclinacao sem atraso do giro; sem filtro extra por frame
+        float target_velocity = total_movement * 0.15f;
         
         player_velocity = player_velocity * 0.8f + target_velocity * 0.2f;
         
@@ -83,49 +75,12 @@ void control_player_with_gyro(void) {
 }
 
 void show_calibration_screen(void) {
-    ssd1306_clear_buffer();
-    ssd1306_draw_string(15, 10, "CALIBRANDO...");
-    ssd1306_draw_string(10, 25, "MANTENHA PARADO");
-    ssd1306_draw_string(25, 40, "3 SEGUNDOS");
-    ssd1306_update_display();
-    
-    vTaskDelay(1000 / portTICK_PERIOD_MS);
-    
-    ssd1306_clear_buffer();
-    ssd1306_draw_string(50, 30, "2...");
-    ssd1306_update_display();
-    vTaskDelay(1000 / portTICK_PERIOD_MS);
-    
-    ssd1306_clear_buffer();
-    ssd1306_draw_string(50, 30, "1...");
-    ssd1306_update_display();
-    vTaskDelay(1000 / portTICK_PERIOD_MS);
-    
-    mpu6050_data_t data;
-    float sum_x = 0, sum_y = 0;
-    int samples = 100;
-    
-    for (int i = 0; i < samples; i++) {
-        if (mpu6050_read_all(&data) == ESP_OK) {
-            sum_x += (float)data.accel_x / 16384.0f;
-            sum_y += (float)data.accel_y / 16384.0f;
-        }
-        vTaskDelay(10 / portTICK_PERIOD_MS);
-    }
-    
-    accel_offset_x = sum_x / samples;
-    accel_offset_y = sum_y / samples;
-    
-    ssd1306_clear_buffer();
-    ssd1306_draw_string(20, 20, "CALIBRADO!");
-    ssd1306_draw_string(10, 35, "INCLINE PARA");
-    ssd1306_draw_string(15, 50, "CONTROLAR");
-    ssd1306_update_display();
-    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    calibration_quick_check();
 }
 
 void start_dodge_blocks_game(void) {
     play_level_up();
+    sensor_set_profile(&MPU6050_PROFILE_BALANCED);
     show_calibration_screen();
     reset_game();
     
@@ -142,13 +97,11 @@ void start_dodge_blocks_game(void) {
             ssd1306_draw_string(5, 50, "PRESS ANY BUTTON");
             ssd1306_update_display();
             
-            while (1) {
-                if (gpio_get_level(40) == 0 || gpio_get_level(38) == 0) {
-                    vTaskDelay(500 / portTICK_PERIOD_MS);
-                    return;
-                }
-                vTaskDelay(50 / portTICK_PERIOD_MS);
+            // Descarta o que foi apertado durante o jogo e espera um aperto novo
+            button_clear_events();
+            while (button_wait_event(&btn_event, UINT32_MAX) != ESP_OK || btn_event.event != BUTTON_EVENT_PRESSED) {
             }
+            return;
         }
 
         control_player_with_gyro();
@@ -177,7 +130,7 @@ void start_dodge_blocks_game(void) {
         char score_text[16];
         snprintf(score_text, sizeof(score_text), "%d", score);
         ssd1306_draw_string(98, 0, score_text);
-        ssd1306_update_display();
+        ssd1306_present();
         vTaskDelay(pdMS_TO_TICKS(GAME_DELAY_MS));
     }
 }
\ No newline at end of file
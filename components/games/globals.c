@@ -1,4 +0,0 @@
-#include "mpu6050.h"
-
-float accel_offset_x = 0.0f;
-float accel_offset_y = 0.0f;
\ No newline at end of file
@@ -0,0 +1,8 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <stdbool.h>
+
+bool calibration_quick_check(void);
+
+#endif
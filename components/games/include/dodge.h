@@ -4,7 +4,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "button.h"
-#include "mpu6050.h"
+#include "sensor.h"
+#include "calibration.h"
 #include "ssd1306.h"
 #include "buzzer.h"
 #include <math.h>
@@ -25,9 +26,6 @@ typedef struct {
     bool active;
 } Block;
 
-extern float accel_offset_x;
-extern float accel_offset_y;
-
 void start_dodge_blocks_game(void);
 void show_calibration_screen(void);
 void control_player_with_gyro(void);
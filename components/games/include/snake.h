@@ -4,7 +4,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "button.h"
-#include "mpu6050.h"
+#include "sensor.h"
+#include "calibration.h"
 #include "ssd1306.h"
 #include "buzzer.h"
 #include <math.h>
@@ -15,9 +16,6 @@
 #define SPEED_DECREMENT 2
 #define MAX_LIVES 3
 
-extern float accel_offset_x;
-extern float accel_offset_y;
-
 typedef struct {
     int x;
     int y;
@@ -4,7 +4,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "button.h"
-#include "mpu6050.h"
+#include "sensor.h"
+#include "calibration.h"
 #include "ssd1306.h"
 #include <math.h>
 #include "buzzer.h"
@@ -18,9 +19,6 @@
 #define MAZE_END_X 14
 #define MAZE_END_Y 6
 
-extern float accel_offset_x;
-extern float accel_offset_y;
-
 typedef struct {
     int x;
     int y;
@@ -14,8 +14,6 @@ static const char *TAG = "MENU";
 
 static MenuOption selected_option = MENU_OPTION_DODGE;
 static bool option_changed = false;
-static uint32_t last_button_press = 0;
-static const uint32_t debounce_delay = 200; 
 
 void menu_init(void) {
     ESP_LOGI(TAG, "MENU INICIADO");
@@ -33,32 +31,25 @@ void menu_update(MenuOption current_option) {
     ssd1306_draw_string(20, 40, current_option == MENU_OPTION_SNAKE_TILT ? "> SNAKE TILT" : "  SNAKE TILT");
     ssd1306_draw_string(20, 50, current_option == MENU_OPTION_PADDLE_PONG ? "> PADDLE PONG" : "  PADDLE_PONG");
 
-    ssd1306_update_display(); 
+    // O present simples descarta o quadro se o anterior ainda estiver saindo, e aqui
+    // nao ha proximo quadro ate o aperto
+    ssd1306_present_blocking();
 
-    uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
-    
-    if (now - last_button_press > debounce_delay) {
-        int btn1_state = button_read_debounced(BUTTON_1_GPIO);
-        int btn2_state = button_read_debounced(BUTTON_2_GPIO);
-        
-        ESP_LOGI(TAG, "BTN1: %d, BTN2: %d", btn1_state, btn2_state);
-        
-        if (btn1_state == 0) {
-            menu_play_nav_sound();
-            last_button_press = now;
-            selected_option = (selected_option + 1) % MENU_OPTION_COUNT;
-            ESP_LOGI(TAG, "NAVEGANDO PARA: %d", selected_option);
-        }
-        
-        if (btn2_state == 0) {
-            menu_play_select_sound();
-            last_button_press = now;
-            option_changed = true;
-            ESP_LOGI(TAG, "OPCAO SELECIONADA: %d", selected_option);
-        }
+    // Bloqueia ate o proximo aperto; o debounce ja foi feito pelo componente de botoes
+    button_event_data_t event;
+    if (button_wait_event(&event, UINT32_MAX) != ESP_OK || event.event != BUTTON_EVENT_PRESSED) {
+        return;
+    }
+
+    if (event.gpio_num == BUTTON_1_GPIO) {
+        menu_play_nav_sound();
+        selected_option = (selected_option + 1) % MENU_OPTION_COUNT;
+        ESP_LOGI(TAG, "NAVEGANDO PARA: %d", selected_option);
+    } else if (event.gpio_num == BUTTON_2_GPIO) {
+        menu_play_select_sound();
+        option_changed = true;
+        ESP_LOGI(TAG, "OPCAO SELECIONADA: %d", selected_option);
     }
-    
-    vTaskDelay(50 / portTICK_PERIOD_MS);
 }
 
 MenuOption menu_get_selected_option(void) {
@@ -1,7 +1,8 @@
 #include "pong.h"
 #include "ssd1306.h" 
-#include "mpu6050.h"
+#include "sensor.h"
 #include "buzzer.h"
+#include "button.h"
 #include "dodge.h"     
 #include <stdlib.h>  
 
@@ -25,6 +26,7 @@ void draw_paddle(Paddle *paddle) {
 
 void start_paddle_pong_game(void) {
     play_level_up();
+    sensor_set_profile(&MPU6050_PROFILE_LOW_LATENCY);
     show_calibration_screen();  
     
     Ball ball;
@@ -34,6 +36,7 @@ void start_paddle_pong_game(void) {
     int score = 0;
     int lives = 3;
     bool game_over = false;
+    button_event_data_t btn_event;
     
     while (1) {
         if (game_over) {
@@ -46,19 +49,25 @@ void start_paddle_pong_game(void) {
             ssd1306_draw_string(5, 50, "PRESS ANY BUTTON");
             ssd1306_update_display();
             
-            while (1) {
-                if (gpio_get_level(40) == 0 || gpio_get_level(38) == 0) {
-                    vTaskDelay(500 / portTICK_PERIOD_MS);
-                    return;
-                }
-                vTaskDelay(50 / portTICK_PERIOD_MS);
+            // Descarta o que foi apertado durante o jogo e espera um aperto novo
+            button_clear_events();
+            while (button_wait_event(&btn_event, UINT32_MAX) != ESP_OK || btn_event.event != BUTTON_EVENT_PRESSED) {
             }
+            return;
         }
         
-        uint8_t accel_data[6];
-        if (mpu6050_read_bytes(0x3B, accel_data, 6) == ESP_OK) {
-            int16_t accel_x_raw = (int16_t)((accel_data[0] << 8) | accel_data[1]);
-            float accel_x = ((float)accel_x_raw / 16384.0f) - accel_offset_x;
+        ssd1306_clear_buffer();
+        char score_text[20];
+        snprintf(score_text, sizeof(score_text), "SCORE:%d", score);
+        ssd1306_draw_string(5, 5, score_text);
+        
+        char lives_text[10];
+        snprintf(lives_text, sizeof(lives_text), "VIDA:%d", lives);
+        ssd1306_draw_string(78, 5, lives_text);
+
+        sensor_sample_t sample;
+        if (sensor_get_latest(&sample)) {
+            float accel_x = sample.orientation.gravity_g[0] - sample.bias.accel_offset_g[0];
             
             paddle.x += (int)(accel_x * 5.0f);
             
@@ -107,19 +116,10 @@ void start_paddle_pong_game(void) {
             }
         }
         
-        ssd1306_clear_buffer();
         draw_ball(&ball);
         draw_paddle(&paddle);
         
-        char score_text[20];
-        snprintf(score_text, sizeof(score_text), "SCORE:%d", score);
-        ssd1306_draw_string(5, 5, score_text);
-        
-        char lives_text[10];
-        snprintf(lives_text, sizeof(lives_text), "VIDA:%d", lives);
-        ssd1306_draw_string(78, 5, lives_text);
-        
-        ssd1306_update_display();
+        ssd1306_present();
         vTaskDelay(20 / portTICK_PERIOD_MS);
     }
 }
\ No newline at end of file
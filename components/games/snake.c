@@ -1,10 +1,7 @@
 #include "snake.h"
 
-extern float accel_offset_x;
-extern float accel_offset_y;
-
-static float filtered_accel_x = 0.0f;
-static float filtered_accel_y = 0.0f;
+static float last_accel_x = 0.0f;
+static float last_accel_y = 0.0f;
 
 void init_snake(Snake *snake) {
     snake->length = 3;
@@ -63,13 +60,7 @@ void draw_food(Food *food) {
     int center_y = food->y * 8 + 4;
     int radius = 3;
     
-    for (int y = -radius; y <= radius; y++) {
-        for (int x = -radius; x <= radius; x++) {
-            if (x*x + y*y <= radius*radius) {
-                ssd1306_set_pixel(center_x + x, center_y + y, true);
-            }
-        }
-    }
+    ssd1306_draw_circle(center_x, center_y, radius, true);
 }
 
 bool check_collision_snake(Snake *snake) {
@@ -93,106 +84,27 @@ int map(int x, int in_min, int in_max, int out_min, int out_max) {
 }
 
 void show_snake_calibration_screen(void) {
-    ssd1306_clear_buffer();
-    ssd1306_draw_string(15, 10, "CALIBRANDO...");
-    ssd1306_draw_string(5, 25, "DEIXE A PLACA");
-    ssd1306_draw_string(10, 35, "COMPLETAMENTE");
-    ssd1306_draw_string(25, 45, "PARADA");
-    ssd1306_update_display();
-    
-    vTaskDelay(2000 / portTICK_PERIOD_MS);
-    
-    for (int i = 5; i > 0; i--) {
-        ssd1306_clear_buffer();
-        char countdown[20];
-        snprintf(countdown, sizeof(countdown), "AGUARDE: %d", i);
-        ssd1306_draw_string(20, 30, countdown);
-        ssd1306_update_display();
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
-    }
-    
-    ssd1306_clear_buffer();
-    ssd1306_draw_string(10, 30, "CALIBRANDO...");
-    ssd1306_update_display();
-    
-    mpu6050_data_t data;
-    double sum_accel_x = 0, sum_accel_y = 0;
-    int valid_samples = 0;
-    int total_attempts = 500;
-    
-    for (int i = 0; i < total_attempts; i++) {
-        if (mpu6050_read_all(&data) == ESP_OK) {
-            float accel_x = (float)data.accel_x / 16384.0f;
-            float accel_y = (float)data.accel_y / 16384.0f;
-            
-            if (fabs(accel_x) < 3.0f && fabs(accel_y) < 3.0f) {
-                sum_accel_x += accel_x;
-                sum_accel_y += accel_y;
-                valid_samples++;
-            }
-        }
-        vTaskDelay(5 / portTICK_PERIOD_MS);
-    }
-    
-    if (valid_samples < 100) {
-        accel_offset_x = 0.0f;
-        accel_offset_y = 0.0f;
-    } else {
-        accel_offset_x = sum_accel_x / valid_samples;
-        accel_offset_y = sum_accel_y / valid_samples;
-    }
-    
-    ssd1306_clear_buffer();
-    if (valid_samples >= 100) {
-        ssd1306_draw_string(15, 15, "CALIBRADO!");
-        ssd1306_draw_string(10, 30, "INCLINE PARA");
-        ssd1306_draw_string(15, 45, "CONTROLAR");
-        play_tone(1200, 200);
-        vTaskDelay(200 / portTICK_PERIOD_MS);
-        play_tone(1500, 300);
-    } else {
-        ssd1306_draw_string(5, 20, "CALIBRACAO");
-        ssd1306_draw_string(20, 35, "FALHOU!");
-        play_tone(500, 500);
-    }
-    ssd1306_update_display();
-    
-    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    calibration_quick_check();
 }
 
 void read_snake_sensor_data(float *accel_x_out, float *accel_y_out) {
-    mpu6050_data_t data;
-    static uint32_t last_read_time = 0;
-    uint32_t current_time = xTaskGetTickCount();
-    
-    if (current_time - last_read_time < pdMS_TO_TICKS(50)) {
-        *accel_x_out = filtered_accel_x;
-        *accel_y_out = filtered_accel_y;
-        return;
-    }
-    last_read_time = current_time;
+    sensor_sample_t sample;
 
-    if (mpu6050_read_all(&data) != ESP_OK) {
-        *accel_x_out = filtered_accel_x;
-        *accel_y_out = filtered_accel_y;
-        return;
+    // A gravidade da fusao ja vem filtrada; so mantem o ultimo valor se nao houver amostra
+    if (sensor_get_latest(&sample)) {
+        last_accel_x = sample.orientation.gravity_g[0] - sample.bias.accel_offset_g[0];
+        last_accel_y = sample.orientation.gravity_g[1] - sample.bias.accel_offset_g[1];
     }
 
-    float raw_accel_x = ((float)data.accel_x / 16384.0f) - accel_offset_x;
-    float raw_accel_y = ((float)data.accel_y / 16384.0f) - accel_offset_y;
-
-    const float alpha = 0.3f;
-    filtered_accel_x = filtered_accel_x * (1.0f - alpha) + raw_accel_x * alpha;
-    filtered_accel_y = filtered_accel_y * (1.0f - alpha) + raw_accel_y * alpha;
-
-    *accel_x_out = filtered_accel_x;
-    *accel_y_out = filtered_accel_y;
+    *accel_x_out = last_accel_x;
+    *accel_y_out = last_accel_y;
 }
 
 void start_snake_tilt_game(void) {
     play_level_up();
     char score_text[20];
     
+    sensor_set_profile(&MPU6050_PROFILE_SMOOTH);
     show_snake_calibration_screen();
     
     Snake snake;
@@ -217,13 +129,11 @@ void start_snake_tilt_game(void) {
             ssd1306_draw_string(5, 50, "PRESS ANY BUTTON");
             ssd1306_update_display();
             
-            while (1) {
-                if (gpio_get_level(40) == 0 || gpio_get_level(38) == 0) {
-                    vTaskDelay(500 / portTICK_PERIOD_MS);
-                    return;
-                }
-                vTaskDelay(50 / portTICK_PERIOD_MS);
+            // Descarta o que foi apertado durante o jogo e espera um aperto novo
+            button_clear_events();
+            while (button_wait_event(&btn_event, UINT32_MAX) != ESP_OK || btn_event.event != BUTTON_EVENT_PRESSED) {
             }
+            return;
         }
         
         float accel_x, accel_y;
@@ -323,7 +233,7 @@ void start_snake_tilt_game(void) {
         int speed_indicator = map(game_speed, MIN_SNAKE_SPEED, INITIAL_SNAKE_SPEED, 5, 123);
         ssd1306_draw_rect(5, 61, speed_indicator, 2, true);
         
-        ssd1306_update_display();
+        ssd1306_present();
         vTaskDelay(20 / portTICK_PERIOD_MS);
     }
 }
\ No newline at end of file
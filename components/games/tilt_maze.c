@@ -11,9 +11,6 @@ static const uint8_t maze[MAZE_HEIGHT][MAZE_WIDTH] = {
     {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1}
 };
 
-extern float accel_offset_x;
-extern float accel_offset_y;
-
 void draw_maze() {
     for (int y = 0; y < MAZE_HEIGHT; y++) {
         for (int x = 0; x < MAZE_WIDTH; x++) {
@@ -45,34 +42,11 @@ bool is_valid_move(int x, int y) {
 void start_tilt_maze_game(void) {
     play_level_up();
     
-    ssd1306_clear_buffer();
-    ssd1306_draw_string(15, 10, "CALIBRANDO...");
-    ssd1306_draw_string(10, 25, "MANTENHA PARADO");
-    ssd1306_draw_string(25, 40, "3 SEGUNDOS");
-    ssd1306_update_display();
-    
-    mpu6050_data_t data;
-    float sum_x = 0, sum_y = 0;
-    int samples = 100;
-    
-    for (int i = 0; i < samples; i++) {
-        if (mpu6050_read_all(&data) == ESP_OK) {
-            sum_x += (float)data.accel_x / 16384.0f;
-            sum_y += (float)data.accel_y / 16384.0f;
-        }
-        vTaskDelay(10 / portTICK_PERIOD_MS);
-    }
-    
-    accel_offset_x = sum_x / samples;
-    accel_offset_y = sum_y / samples;
-    
-    ssd1306_clear_buffer();
-    ssd1306_draw_string(20, 20, "CALIBRADO!");
-    ssd1306_draw_string(10, 35, "INCLINE PARA");
-    ssd1306_draw_string(15, 50, "CONTROLAR");
-    ssd1306_update_display();
-    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    // Movimento em passos de uma casa: vale mais um sinal limpo que a latencia
+    sensor_set_profile(&MPU6050_PROFILE_SMOOTH);
+    calibration_quick_check();
     
+    sensor_sample_t sample;
     MazePlayer player = {1, 1};
     bool game_completed = false;
     uint32_t start_time = xTaskGetTickCount();
@@ -91,22 +65,16 @@ void start_tilt_maze_game(void) {
             ssd1306_draw_string(5, 50, "PRESS ANY BUTTON");
             ssd1306_update_display();
             
-            while (1) {
-                if (gpio_get_level(40) == 0 || gpio_get_level(38) == 0) {
-                    vTaskDelay(500 / portTICK_PERIOD_MS);
-                    return;
-                }
-                vTaskDelay(50 / portTICK_PERIOD_MS);
+            // Descarta o que foi apertado durante o jogo e espera um aperto novo
+            button_clear_events();
+            while (button_wait_event(&btn_event, UINT32_MAX) != ESP_OK || btn_event.event != BUTTON_EVENT_PRESSED) {
             }
+            return;
         }
         
-        uint8_t accel_data[6];
-        if (mpu6050_read_bytes(0x3B, accel_data, 6) == ESP_OK) {
-            int16_t accel_x_raw = (int16_t)((accel_data[0] << 8) | accel_data[1]);
-            int16_t accel_y_raw = (int16_t)((accel_data[2] << 8) | accel_data[3]);
-            
-            float accel_x = ((float)accel_x_raw / 16384.0f) - accel_offset_x;
-            float accel_y = ((float)accel_y_raw / 16384.0f) - accel_offset_y;
+        if (sensor_get_latest(&sample)) {
+            float accel_x = sample.orientation.gravity_g[0] - sample.bias.accel_offset_g[0];
+            float accel_y = sample.orientation.gravity_g[1] - sample.bias.accel_offset_g[1];
             
             int new_x = player.x;
             int new_y = player.y;
@@ -139,7 +107,7 @@ void start_tilt_maze_game(void) {
         snprintf(time_text, sizeof(time_text), "%lu", (unsigned long)current_time);
         ssd1306_draw_string(98, 0, time_text);
         
-        ssd1306_update_display();
+        ssd1306_present();
         vTaskDelay(150 / portTICK_PERIOD_MS);
     }
 }
\ No newline at end of file
@@ -1,4 +1,16 @@
+#include <stdio.h>
+#include <string.h>
 #include "i2clib.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+
+static const char *TAG = "I2CLIB";
 
 typedef enum
 {
@@ -6,52 +18,1080 @@ typedef enum
   I2C_STATE_ACTIVE,
   I2C_STATE_SLEEPING,
   I2C_STATE_STUCK,
-  I2C_STATE_ERROR
+  I2C_STATE_ERROR,
+  I2C_STATE_FAILED  // a recuperacao falhou; a tarefa de saude tenta de novo
 } i2c_state_t;
 
-static i2c_state_t current_i2c_state = I2C_STATE_UNKNOWN;
-static uint32_t i2c_recovery_count = 0;
-
 TaskHandle_t i2c_cleanup_task_handle;
+static StaticTask_t i2c_cleanup_task_tcb;
+static StackType_t i2c_cleanup_task_stack[I2C_HEALTH_TASK_STACK];
 
-esp_err_t i2c_init(void)
+// Cada controlador tem o proprio arbitro, filas e estado, entao dois barramentos
+// transferem em paralelo
+struct i2c_bus
+{
+  bool in_use;
+  int index;
+  i2c_master_bus_config_t config;
+  i2c_master_bus_handle_t handle;
+  SemaphoreHandle_t lock;
+  StaticSemaphore_t lock_storage;
+
+  // Uma fila por prioridade, com ponteiros para as transacoes
+  QueueHandle_t queues[I2C_PRIORITY_COUNT];
+  StaticQueue_t queue_storage[I2C_PRIORITY_COUNT];
+  uint8_t queue_items[I2C_PRIORITY_COUNT][I2C_QUEUE_LENGTH * sizeof(i2c_request_t *)];
+  i2c_queue_stats_t queue_stats[I2C_PRIORITY_COUNT];
+
+  TaskHandle_t arbiter_task;
+  StaticTask_t arbiter_task_tcb;
+  StackType_t arbiter_task_stack[I2C_ARBITER_TASK_STACK];
+
+  i2c_state_t state;
+  uint32_t recovery_count;
+  // Transacoes concluidas, usadas pela verificacao periodica para saber se o barramento ficou ocioso
+  uint32_t transfer_count;
+  uint32_t last_transfer_count;
+};
+
+static struct i2c_bus i2c_buses[I2C_MAX_BUSES];
+
+// Barramento escolhido para cada endereco; enderecos sem entrada ficam no primario
+static struct
+{
+  uint8_t addr;
+  uint8_t bus;
+} i2c_bindings[I2C_MAX_DEVICES];
+static int i2c_binding_count = 0;
+
+struct i2c_device
+{
+  bool in_use;
+  struct i2c_bus *bus;
+  i2c_device_desc_t desc;
+  i2c_master_dev_handle_t handle;       // handle em uso, um dos dois abaixo
+  i2c_master_dev_handle_t fast_handle;  // na velocidade negociada, quando ela passa da segura
+  i2c_master_dev_handle_t safe_handle;  // criado junto, para o fallback trocar de handle sem alocar
+  uint32_t speed_hz;
+  uint32_t error_streak;
+#if I2C_STATS_ENABLED
+  i2c_device_stats_t stats;
+#endif
+};
+
+// Descritores pre-alocados: registrar um dispositivo so preenche uma entrada desta tabela
+static struct i2c_device i2c_devices[I2C_MAX_DEVICES];
+
+// Velocidades tentadas na negociacao, da mais rapida para a mais lenta
+static const uint32_t i2c_speed_steps[] = {I2C_SPEED_FAST_PLUS_HZ, I2C_SPEED_FAST_HZ, I2C_SPEED_STANDARD_HZ};
+
+static void i2c_arbiter_task(void *arg);
+static void i2c_health_task(void *arg);
+
+static void i2c_fill_bus_config(const i2c_bus_pins_t *pins, i2c_master_bus_config_t *config)
 {
-  i2c_config_t conf = {
-      .mode = I2C_MODE_MASTER,
-      .sda_io_num = I2C_MASTER_SDA_IO,
-      .sda_pullup_en = GPIO_PULLUP_ENABLE,
-      .scl_io_num = I2C_MASTER_SCL_IO,
-      .scl_pullup_en = GPIO_PULLUP_ENABLE,
-      .master.clk_speed = I2C_MASTER_FREQ_HZ,
+  *config = (i2c_master_bus_config_t){
+      .i2c_port = pins->port,
+      .sda_io_num = pins->sda_io,
+      .scl_io_num = pins->scl_io,
+      .clk_source = I2C_CLK_SRC_DEFAULT,
+      .glitch_ignore_cnt = I2C_MASTER_GLITCH_IGNORE,
+      .flags.enable_internal_pullup = true,
   };
+}
+
+esp_err_t i2c_bus_init(int bus_index, const i2c_bus_pins_t *pins)
+{
+  if (bus_index < 0 || bus_index >= I2C_MAX_BUSES || pins == NULL)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
 
-  esp_err_t ret = i2c_param_config(I2C_MASTER_NUM, &conf);
+  struct i2c_bus *bus = &i2c_buses[bus_index];
+  if (bus->in_use)
+  {
+    return ESP_OK;
+  }
+
+  bus->index = bus_index;
+  i2c_fill_bus_config(pins, &bus->config);
+  esp_err_t ret = i2c_new_master_bus(&bus->config, &bus->handle);
   if (ret != ESP_OK)
   {
     return ret;
   }
 
-  ret = i2c_driver_install(I2C_MASTER_NUM, conf.mode, I2C_MASTER_RX_BUF_DISABLE, I2C_MASTER_TX_BUF_DISABLE, 0);
-  return ret;
+  bus->lock = xSemaphoreCreateMutexStatic(&bus->lock_storage);
+  for (int i = 0; i < I2C_PRIORITY_COUNT; i++)
+  {
+    bus->queues[i] = xQueueCreateStatic(I2C_QUEUE_LENGTH, sizeof(i2c_request_t *), bus->queue_items[i], &bus->queue_storage[i]);
+  }
+
+  bus->arbiter_task = xTaskCreateStaticPinnedToCore(i2c_arbiter_task, "i2c_arbiter", I2C_ARBITER_TASK_STACK, bus,
+                                                    I2C_ARBITER_TASK_PRIORITY, bus->arbiter_task_stack,
+                                                    &bus->arbiter_task_tcb, I2C_ARBITER_TASK_CORE);
+  if (bus->arbiter_task == NULL)
+  {
+    return ESP_FAIL;
+  }
+
+  // Uma so tarefa de saude cuida de todos os barramentos
+  if (i2c_cleanup_task_handle == NULL)
+  {
+    i2c_cleanup_task_handle = xTaskCreateStaticPinnedToCore(i2c_health_task, "i2c_health", I2C_HEALTH_TASK_STACK, NULL,
+                                                            I2C_HEALTH_TASK_PRIORITY, i2c_cleanup_task_stack,
+                                                            &i2c_cleanup_task_tcb, I2C_ARBITER_TASK_CORE);
+    if (i2c_cleanup_task_handle == NULL)
+    {
+      return ESP_FAIL;
+    }
+  }
+
+  bus->state = I2C_STATE_ACTIVE;
+  bus->in_use = true;
+  ESP_LOGI(TAG, "Barramento %d na porta %d (SDA %d, SCL %d)", bus_index, pins->port, pins->sda_io, pins->scl_io);
+  return ESP_OK;
+}
+
+// Modo de um barramento so, como a placa atual: sensor e display nos pinos I2C_MASTER_*
+esp_err_t i2c_init(void)
+{
+  const i2c_bus_pins_t pins = {
+      .port = I2C_MASTER_NUM,
+      .sda_io = I2C_MASTER_SDA_IO,
+      .scl_io = I2C_MASTER_SCL_IO,
+  };
+  return i2c_bus_init(I2C_BUS_PRIMARY, &pins);
+}
+
+// Sobe um barramento temporario so para ver se addr responde nesses pinos. Deve ser
+// chamada antes de i2c_bus_init para os mesmos pinos.
+bool i2c_bus_detect(const i2c_bus_pins_t *pins, uint8_t addr)
+{
+  i2c_master_bus_config_t config;
+  i2c_master_bus_handle_t handle;
+
+  i2c_fill_bus_config(pins, &config);
+  if (i2c_new_master_bus(&config, &handle) != ESP_OK)
+  {
+    return false;
+  }
+  bool found = i2c_master_probe(handle, addr, I2C_DEFAULT_TIMEOUT_MS) == ESP_OK;
+  i2c_del_master_bus(handle);
+  return found;
+}
+
+// Define em qual barramento o dispositivo sera registrado; chamar antes do init do driver
+esp_err_t i2c_bind_device(uint8_t addr, int bus)
+{
+  if (bus < 0 || bus >= I2C_MAX_BUSES)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  for (int i = 0; i < i2c_binding_count; i++)
+  {
+    if (i2c_bindings[i].addr == addr)
+    {
+      i2c_bindings[i].bus = bus;
+      return ESP_OK;
+    }
+  }
+  if (i2c_binding_count >= I2C_MAX_DEVICES)
+  {
+    return ESP_ERR_NO_MEM;
+  }
+  i2c_bindings[i2c_binding_count].addr = addr;
+  i2c_bindings[i2c_binding_count].bus = bus;
+  i2c_binding_count++;
+  return ESP_OK;
+}
+
+int i2c_get_device_bus(uint8_t addr)
+{
+  for (int i = 0; i < i2c_binding_count; i++)
+  {
+    if (i2c_bindings[i].addr == addr)
+    {
+      return i2c_bindings[i].bus;
+    }
+  }
+  return I2C_BUS_PRIMARY;
 }
 
 void i2c_scan(void)
 {
   int devices_found = 0;
 
-  for (int addr = 1; addr < 127; addr++)
+  for (int b = 0; b < I2C_MAX_BUSES; b++)
+  {
+    struct i2c_bus *bus = &i2c_buses[b];
+    if (!bus->in_use)
+    {
+      continue;
+    }
+
+    xSemaphoreTake(bus->lock, portMAX_DELAY);
+    for (int addr = 1; addr < 127; addr++)
+    {
+      esp_err_t ret = i2c_master_probe(bus->handle, addr, 100);
+
+      if (ret == ESP_OK)
+      {
+        devices_found++;
+      }
+    }
+    xSemaphoreGive(bus->lock);
+  }
+}
+
+static void i2c_device_detach(struct i2c_device *dev)
+{
+  if (dev->fast_handle != NULL)
+  {
+    i2c_master_bus_rm_device(dev->fast_handle);
+  }
+  if (dev->safe_handle != NULL)
+  {
+    i2c_master_bus_rm_device(dev->safe_handle);
+  }
+  dev->handle = NULL;
+  dev->fast_handle = NULL;
+  dev->safe_handle = NULL;
+}
+
+static esp_err_t i2c_device_add_handle(struct i2c_device *dev, uint32_t speed_hz, i2c_master_dev_handle_t *out)
+{
+  i2c_device_config_t dev_config = {
+      .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+      .device_address = dev->desc.addr,
+      .scl_speed_hz = speed_hz,
+  };
+  return i2c_master_bus_add_device(dev->bus->handle, &dev_config, out);
+}
+
+// Recria os handles do driver com outra velocidade. Aloca memoria, entao so e usada na
+// negociacao e na recuperacao, nunca no caminho normal: o fallback so troca para o
+// safe_handle ja criado aqui. Chamar com o lock do barramento tomado.
+static esp_err_t i2c_device_attach(struct i2c_device *dev, uint32_t speed_hz)
+{
+  i2c_device_detach(dev);
+
+  esp_err_t ret = i2c_device_add_handle(dev, I2C_SPEED_SAFE_HZ, &dev->safe_handle);
+  if (ret == ESP_OK && speed_hz > I2C_SPEED_SAFE_HZ)
+  {
+    ret = i2c_device_add_handle(dev, speed_hz, &dev->fast_handle);
+  }
+  if (ret != ESP_OK)
+  {
+    i2c_device_detach(dev);
+    return ret;
+  }
+
+  dev->handle = dev->fast_handle != NULL ? dev->fast_handle : dev->safe_handle;
+  dev->speed_hz = dev->fast_handle != NULL ? speed_hz : I2C_SPEED_SAFE_HZ;
+  return ESP_OK;
+}
+
+static int i2c_device_timeout(struct i2c_device *dev)
+{
+  return dev->desc.timeout_ms > 0 ? dev->desc.timeout_ms : I2C_DEFAULT_TIMEOUT_MS;
+}
+
+static esp_err_t i2c_device_probe(struct i2c_device *dev)
+{
+  if (dev->desc.probe_reg == I2C_PROBE_ACK_ONLY)
+  {
+    const uint8_t zero = 0x00;
+    return i2c_master_transmit(dev->handle, &zero, 1, i2c_device_timeout(dev));
+  }
+
+  uint8_t reg = (uint8_t)dev->desc.probe_reg;
+  uint8_t value = 0;
+  esp_err_t ret = i2c_master_transmit_receive(dev->handle, &reg, 1, &value, 1, i2c_device_timeout(dev));
+  if (ret == ESP_OK && value != dev->desc.probe_value)
   {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (addr << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_stop(cmd);
+    ret = ESP_ERR_INVALID_RESPONSE;
+  }
+  return ret;
+}
 
-    esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, 100 / portTICK_PERIOD_MS);
-    i2c_cmd_link_delete(cmd);
+esp_err_t i2c_device_register(const i2c_device_desc_t *desc, i2c_device_handle_t *out_handle)
+{
+  if (desc == NULL || out_handle == NULL)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
 
+  struct i2c_bus *bus = &i2c_buses[i2c_get_device_bus(desc->addr)];
+  if (!bus->in_use)
+  {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  struct i2c_device *dev = NULL;
+  for (int i = 0; i < I2C_MAX_DEVICES; i++)
+  {
+    if (i2c_devices[i].in_use && i2c_devices[i].desc.addr == desc->addr)
+    {
+      dev = &i2c_devices[i];
+      break;
+    }
+    if (!i2c_devices[i].in_use && dev == NULL)
+    {
+      dev = &i2c_devices[i];
+    }
+  }
+  if (dev == NULL)
+  {
+    return ESP_ERR_NO_MEM;
+  }
+
+  // Um endereco religado a outro barramento sai do antigo antes
+  if (dev->in_use && dev->bus != bus)
+  {
+    xSemaphoreTake(dev->bus->lock, portMAX_DELAY);
+    i2c_device_detach(dev);
+    xSemaphoreGive(dev->bus->lock);
+  }
+
+  xSemaphoreTake(bus->lock, portMAX_DELAY);
+  dev->in_use = true;
+  dev->bus = bus;
+  dev->desc = *desc;
+  dev->error_streak = 0;
+  *out_handle = dev;
+
+  // Fica com a maior velocidade em que o dispositivo responde corretamente
+  esp_err_t ret = ESP_ERR_NOT_FOUND;
+  for (int i = 0; i < sizeof(i2c_speed_steps) / sizeof(i2c_speed_steps[0]); i++)
+  {
+    if (i2c_speed_steps[i] > desc->max_speed_hz)
+    {
+      continue;
+    }
+    ret = i2c_device_attach(dev, i2c_speed_steps[i]);
+    if (ret == ESP_OK)
+    {
+      ret = i2c_device_probe(dev);
+    }
     if (ret == ESP_OK)
     {
-      devices_found++;
+      break;
+    }
+  }
+  if (ret != ESP_OK)
+  {
+    i2c_device_attach(dev, I2C_SPEED_SAFE_HZ);
+  }
+  xSemaphoreGive(bus->lock);
+
+  if (ret == ESP_OK)
+  {
+    ESP_LOGI(TAG, "Dispositivo 0x%02X negociado a %lu Hz no barramento %d", desc->addr, (unsigned long)dev->speed_hz, bus->index);
+  }
+  else
+  {
+    ESP_LOGE(TAG, "Dispositivo 0x%02X nao respondeu: %s", desc->addr, esp_err_to_name(ret));
+  }
+  return ret;
+}
+
+// Depois de I2C_FALLBACK_ERROR_COUNT erros seguidos o dispositivo volta para a velocidade
+// segura. Roda no arbitro, entao so troca para o handle pre-criado.
+static void i2c_device_account(struct i2c_device *dev, esp_err_t ret)
+{
+  if (ret == ESP_OK)
+  {
+    dev->error_streak = 0;
+    return;
+  }
+
+  dev->error_streak++;
+  if (dev->error_streak >= I2C_FALLBACK_ERROR_COUNT && dev->speed_hz > I2C_SPEED_SAFE_HZ)
+  {
+    ESP_LOGW(TAG, "Dispositivo 0x%02X com erros seguidos, reduzindo para %lu Hz", dev->desc.addr, (unsigned long)I2C_SPEED_SAFE_HZ);
+    dev->handle = dev->safe_handle;
+    dev->speed_hz = I2C_SPEED_SAFE_HZ;
+    dev->error_streak = 0;
+  }
+}
+
+// Timeout ou controlador em estado invalido indicam barramento travado; NACK so indica
+// que a peca nao respondeu. Chamar com o lock do barramento tomado.
+static void i2c_update_state(struct i2c_bus *bus, esp_err_t ret)
+{
+  if (ret == ESP_OK)
+  {
+    bus->state = I2C_STATE_ACTIVE;
+    bus->transfer_count++;
+  }
+  else if (ret == ESP_ERR_TIMEOUT || ret == ESP_ERR_INVALID_STATE)
+  {
+    if (bus->state != I2C_STATE_STUCK)
+    {
+      ESP_LOGW(TAG, "Barramento %d travado: %s", bus->index, esp_err_to_name(ret));
+      bus->state = I2C_STATE_STUCK;
+      xTaskNotifyGive(i2c_cleanup_task_handle);
     }
   }
-}
\ No newline at end of file
+  else
+  {
+    bus->state = I2C_STATE_ERROR;
+  }
+}
+
+#if I2C_STATS_ENABLED
+// Chamar com o lock do barramento tomado
+static void i2c_stats_record(struct i2c_device *dev, esp_err_t ret, size_t bytes, int64_t latency_us)
+{
+  i2c_device_stats_t *stats = &dev->stats;
+
+  stats->transactions++;
+  stats->bytes += bytes;
+  if (ret == ESP_ERR_TIMEOUT)
+  {
+    stats->timeouts++;
+  }
+  else if (ret != ESP_OK)
+  {
+    stats->errors++;
+  }
+
+  // Bucket n conta latencias de 2^(n-1) ate 2^n - 1 us; o ultimo acumula o resto
+  uint32_t us = latency_us > 0 ? (uint32_t)latency_us : 0;
+  int bucket = us == 0 ? 0 : 32 - __builtin_clz(us);
+  if (bucket >= I2C_STATS_BUCKETS)
+  {
+    bucket = I2C_STATS_BUCKETS - 1;
+  }
+  stats->latency_hist[bucket]++;
+  if (us > stats->max_latency_us)
+  {
+    stats->max_latency_us = us;
+  }
+}
+#endif
+
+// Executa o proximo bloco da transacao com o barramento tomado. Retorna true quando
+// a transacao terminou, com sucesso ou erro.
+static bool i2c_transaction_step(i2c_request_t *t)
+{
+  struct i2c_device *dev = t->dev;
+  struct i2c_bus *bus = dev->bus;
+  i2c_queue_stats_t *stats = &bus->queue_stats[dev->desc.priority];
+
+  if (!t->started)
+  {
+    uint32_t wait_us = (uint32_t)(esp_timer_get_time() - t->queued_us);
+    stats->transactions++;
+    stats->total_wait_us += wait_us;
+    if (wait_us > stats->max_wait_us)
+    {
+      stats->max_wait_us = wait_us;
+    }
+    t->started = true;
+  }
+
+  size_t len = t->data_len - t->offset;
+  if (dev->desc.chunk_size > 0 && len > dev->desc.chunk_size)
+  {
+    len = dev->desc.chunk_size;
+  }
+  stats->chunks++;
+
+  esp_err_t ret;
+  int timeout_ms = i2c_device_timeout(dev);
+  xSemaphoreTake(bus->lock, portMAX_DELAY);
+  if (bus->state == I2C_STATE_STUCK || bus->state == I2C_STATE_FAILED)
+  {
+    // Falha na hora em vez de esperar o prazo de novo; a tarefa de saude recupera o barramento
+    xSemaphoreGive(bus->lock);
+    t->ret = ESP_ERR_INVALID_STATE;
+    return true;
+  }
+
+#if I2C_STATS_ENABLED
+  int64_t bus_start_us = esp_timer_get_time();
+#endif
+  if (t->read_len > 0)
+  {
+    ret = i2c_master_transmit_receive(dev->handle, t->head, t->head_len, t->read_buf, t->read_len, timeout_ms);
+  }
+  else if (t->head_len > 0 && len > 0)
+  {
+    // Cabecalho e dados saem na mesma transacao sem copiar para um buffer intermediario
+    i2c_master_transmit_multi_buffer_info_t buffers[2] = {
+        {.write_buffer = (uint8_t *)t->head, .buffer_size = t->head_len},
+        {.write_buffer = (uint8_t *)t->data + t->offset, .buffer_size = len},
+    };
+    ret = i2c_master_multi_buffer_transmit(dev->handle, buffers, 2, timeout_ms);
+  }
+  else if (t->head_len > 0)
+  {
+    ret = i2c_master_transmit(dev->handle, t->head, t->head_len, timeout_ms);
+  }
+  else
+  {
+    ret = i2c_master_transmit(dev->handle, t->data + t->offset, len, timeout_ms);
+  }
+#if I2C_STATS_ENABLED
+  i2c_stats_record(dev, ret, t->head_len + len + t->read_len, esp_timer_get_time() - bus_start_us);
+#endif
+  i2c_device_account(dev, ret);
+  i2c_update_state(bus, ret);
+  xSemaphoreGive(bus->lock);
+
+  t->offset += len;
+  t->ret = ret;
+  return ret != ESP_OK || t->offset >= t->data_len;
+}
+
+static void i2c_transaction_complete(i2c_request_t *t)
+{
+  if (!t->async)
+  {
+    // Depois da notificacao a requisicao pode sair de escopo na pilha de quem chamou
+    TaskHandle_t waiter = t->waiter;
+    xTaskNotifyGiveIndexed(waiter, I2C_NOTIFY_INDEX);
+    return;
+  }
+
+  TaskHandle_t waiter = t->waiter;
+  if (t->cb != NULL)
+  {
+    // Roda na tarefa do arbitro: o callback precisa ser curto e nao pode usar o barramento
+    t->cb(t, t->cb_arg);
+  }
+  __atomic_store_n(&t->pending, false, __ATOMIC_RELEASE);
+  xTaskNotifyIndexed(waiter, I2C_ASYNC_NOTIFY_INDEX, NOTIF_I2C_DONE, eSetBits);
+}
+
+// Atende sempre a fila HIGH primeiro. Uma escrita LOW grande anda um bloco por vez,
+// entao uma leitura de sensor espera no maximo um bloco em vez do quadro inteiro.
+static void i2c_arbiter_task(void *arg)
+{
+  struct i2c_bus *bus = arg;
+  i2c_request_t *low = NULL;
+
+  while (1)
+  {
+    i2c_request_t *t;
+    if (xQueueReceive(bus->queues[I2C_PRIORITY_HIGH], &t, 0) == pdTRUE)
+    {
+      while (!i2c_transaction_step(t))
+      {
+      }
+      i2c_transaction_complete(t);
+      continue;
+    }
+
+    if (low == NULL && xQueueReceive(bus->queues[I2C_PRIORITY_LOW], &low, 0) != pdTRUE)
+    {
+      low = NULL;
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      continue;
+    }
+
+    if (i2c_transaction_step(low))
+    {
+      i2c_transaction_complete(low);
+      low = NULL;
+    }
+  }
+}
+
+static esp_err_t i2c_request_prepare(i2c_device_handle_t dev, i2c_request_t *req, const uint8_t *head, size_t head_len,
+                                     const uint8_t *data, size_t data_len, uint8_t *read_buf, size_t read_len)
+{
+  if (dev == NULL || dev->handle == NULL || !dev->bus->in_use)
+  {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (__atomic_load_n(&req->pending, __ATOMIC_ACQUIRE))
+  {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  req->dev = dev;
+  req->head = head;
+  req->head_len = head_len;
+  req->data = data;
+  req->data_len = data_len;
+  req->read_buf = read_buf;
+  req->read_len = read_len;
+  req->offset = 0;
+  req->started = false;
+  req->waiter = xTaskGetCurrentTaskHandle();
+  req->ret = ESP_OK;
+  return ESP_OK;
+}
+
+static esp_err_t i2c_request_enqueue(i2c_request_t *req, TickType_t ticks_to_wait)
+{
+  req->queued_us = esp_timer_get_time();
+  struct i2c_bus *bus = req->dev->bus;
+  if (xQueueSend(bus->queues[req->dev->desc.priority], &req, ticks_to_wait) != pdTRUE)
+  {
+    return ESP_ERR_NO_MEM;
+  }
+  xTaskNotifyGive(bus->arbiter_task);
+  return ESP_OK;
+}
+
+static esp_err_t i2c_request_run(i2c_request_t *req)
+{
+  req->async = false;
+  i2c_request_enqueue(req, portMAX_DELAY);
+  ulTaskNotifyTakeIndexed(I2C_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+  return req->ret;
+}
+
+// Cabecalhos curtos sao copiados para a requisicao, entao o registrador pode vir da pilha
+static esp_err_t i2c_request_start(i2c_request_t *req, i2c_done_cb_t cb, void *cb_arg)
+{
+  if (req->head_len > 0 && req->head_len <= I2C_REQUEST_HEAD_MAX)
+  {
+    memcpy(req->head_copy, req->head, req->head_len);
+    req->head = req->head_copy;
+  }
+  req->async = true;
+  req->cb = cb;
+  req->cb_arg = cb_arg;
+  __atomic_store_n(&req->pending, true, __ATOMIC_RELEASE);
+
+  // Nao bloqueia: com a fila cheia a requisicao volta com erro
+  esp_err_t ret = i2c_request_enqueue(req, 0);
+  if (ret != ESP_OK)
+  {
+    __atomic_store_n(&req->pending, false, __ATOMIC_RELEASE);
+    req->ret = ret;
+  }
+  return ret;
+}
+
+esp_err_t i2c_device_transmit(i2c_device_handle_t dev, const uint8_t *head, size_t head_len, const uint8_t *data, size_t data_len)
+{
+  i2c_request_t req = {0};
+  esp_err_t ret = i2c_request_prepare(dev, &req, head, head_len, data, data_len, NULL, 0);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  return i2c_request_run(&req);
+}
+
+esp_err_t i2c_device_write_read(i2c_device_handle_t dev, const uint8_t *write_buf, size_t write_len, uint8_t *read_buf, size_t read_len)
+{
+  if (read_len == 0)
+  {
+    return ESP_ERR_INVALID_SIZE;
+  }
+
+  i2c_request_t req = {0};
+  esp_err_t ret = i2c_request_prepare(dev, &req, write_buf, write_len, NULL, 0, read_buf, read_len);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  return i2c_request_run(&req);
+}
+
+esp_err_t i2c_device_transmit_async(i2c_device_handle_t dev, i2c_request_t *req, const uint8_t *head, size_t head_len,
+                                    const uint8_t *data, size_t data_len, i2c_done_cb_t cb, void *cb_arg)
+{
+  if (req == NULL)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  esp_err_t ret = i2c_request_prepare(dev, req, head, head_len, data, data_len, NULL, 0);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  return i2c_request_start(req, cb, cb_arg);
+}
+
+esp_err_t i2c_device_write_read_async(i2c_device_handle_t dev, i2c_request_t *req, const uint8_t *write_buf, size_t write_len,
+                                      uint8_t *read_buf, size_t read_len, i2c_done_cb_t cb, void *cb_arg)
+{
+  if (req == NULL)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (read_len == 0)
+  {
+    return ESP_ERR_INVALID_SIZE;
+  }
+
+  esp_err_t ret = i2c_request_prepare(dev, req, write_buf, write_len, NULL, 0, read_buf, read_len);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  return i2c_request_start(req, cb, cb_arg);
+}
+
+bool i2c_request_done(const i2c_request_t *req)
+{
+  return !__atomic_load_n(&req->pending, __ATOMIC_ACQUIRE);
+}
+
+esp_err_t i2c_request_wait(i2c_request_t *req, TickType_t ticks_to_wait)
+{
+  TickType_t start = xTaskGetTickCount();
+
+  // NOTIF_I2C_DONE e compartilhado por todas as requisicoes da tarefa, entao cada
+  // acordada so confirma olhando o estado desta
+  while (!i2c_request_done(req))
+  {
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    if (ticks_to_wait != portMAX_DELAY && elapsed >= ticks_to_wait)
+    {
+      return ESP_ERR_TIMEOUT;
+    }
+    xTaskNotifyWaitIndexed(I2C_ASYNC_NOTIFY_INDEX, 0, NOTIF_I2C_DONE, NULL,
+                           ticks_to_wait == portMAX_DELAY ? portMAX_DELAY : ticks_to_wait - elapsed);
+  }
+  return req->ret;
+}
+
+uint32_t i2c_get_device_speed(uint8_t addr)
+{
+  for (int i = 0; i < I2C_MAX_DEVICES; i++)
+  {
+    if (i2c_devices[i].in_use && i2c_devices[i].desc.addr == addr)
+    {
+      return i2c_devices[i].speed_hz;
+    }
+  }
+  return 0;
+}
+
+// Solta um escravo que ficou segurando SDA: pulsos em SCL ate SDA subir e depois um STOP
+static void i2c_clock_out_stuck_slave(struct i2c_bus *bus)
+{
+  gpio_num_t sda = bus->config.sda_io_num;
+  gpio_num_t scl = bus->config.scl_io_num;
+  gpio_config_t io_config = {
+      .pin_bit_mask = (1ULL << scl) | (1ULL << sda),
+      .mode = GPIO_MODE_INPUT_OUTPUT_OD,
+      .pull_up_en = GPIO_PULLUP_ENABLE,
+      .pull_down_en = GPIO_PULLDOWN_DISABLE,
+      .intr_type = GPIO_INTR_DISABLE,
+  };
+  gpio_config(&io_config);
+  gpio_set_level(sda, 1);
+  gpio_set_level(scl, 1);
+  esp_rom_delay_us(5);
+
+  for (int i = 0; i < I2C_RECOVERY_CLOCK_PULSES && gpio_get_level(sda) == 0; i++)
+  {
+    gpio_set_level(scl, 0);
+    esp_rom_delay_us(5);
+    gpio_set_level(scl, 1);
+    esp_rom_delay_us(5);
+  }
+
+  gpio_set_level(scl, 0);
+  gpio_set_level(sda, 0);
+  esp_rom_delay_us(5);
+  gpio_set_level(scl, 1);
+  esp_rom_delay_us(5);
+  gpio_set_level(sda, 1);
+  esp_rom_delay_us(5);
+}
+
+static bool i2c_lines_released(struct i2c_bus *bus)
+{
+  return gpio_get_level(bus->config.sda_io_num) == 1 && gpio_get_level(bus->config.scl_io_num) == 1;
+}
+
+static bool i2c_bus_active(struct i2c_bus *bus)
+{
+  // As linhas so podem ser lidas com o barramento parado; se ele esta ocupado, esta vivo
+  if (xSemaphoreTake(bus->lock, pdMS_TO_TICKS(I2C_DEFAULT_TIMEOUT_MS)) != pdTRUE)
+  {
+    return true;
+  }
+  bool released = i2c_lines_released(bus);
+  xSemaphoreGive(bus->lock);
+  return released && bus->state != I2C_STATE_STUCK && bus->state != I2C_STATE_FAILED;
+}
+
+bool i2c_check_bus_active(void)
+{
+  for (int b = 0; b < I2C_MAX_BUSES; b++)
+  {
+    if (i2c_buses[b].in_use && !i2c_bus_active(&i2c_buses[b]))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void i2c_bus_recover(struct i2c_bus *bus)
+{
+  xSemaphoreTake(bus->lock, portMAX_DELAY);
+  int64_t start = esp_timer_get_time();
+
+  // Primeiro o reset do proprio controlador, que ja gera pulsos em SCL. Sem controlador,
+  // de uma recuperacao anterior que falhou, vai direto para a recriacao.
+  esp_err_t ret = ESP_ERR_INVALID_STATE;
+  if (bus->handle != NULL)
+  {
+    ret = i2c_master_bus_reset(bus->handle);
+  }
+  if (ret != ESP_OK || !i2c_lines_released(bus))
+  {
+    // SDA continua preso: desmonta o barramento e gera os pulsos manualmente
+    for (int i = 0; i < I2C_MAX_DEVICES; i++)
+    {
+      if (i2c_devices[i].bus == bus)
+      {
+        i2c_device_detach(&i2c_devices[i]);
+      }
+    }
+    if (bus->handle != NULL)
+    {
+      i2c_del_master_bus(bus->handle);
+      bus->handle = NULL;
+    }
+
+    i2c_clock_out_stuck_slave(bus);
+
+    ret = i2c_new_master_bus(&bus->config, &bus->handle);
+    if (ret != ESP_OK)
+    {
+      bus->handle = NULL;
+    }
+  }
+
+  // Refaz os handles que faltam: todos depois da recriacao, ou os que uma tentativa
+  // anterior nao conseguiu criar
+  for (int i = 0; i < I2C_MAX_DEVICES && ret == ESP_OK; i++)
+  {
+    if (i2c_devices[i].in_use && i2c_devices[i].bus == bus && i2c_devices[i].handle == NULL)
+    {
+      ret = i2c_device_attach(&i2c_devices[i], i2c_devices[i].speed_hz);
+    }
+  }
+
+  bus->recovery_count++;
+  bool recovered = ret == ESP_OK && i2c_lines_released(bus);
+  bus->state = recovered ? I2C_STATE_ACTIVE : I2C_STATE_FAILED;
+  int64_t elapsed_us = esp_timer_get_time() - start;
+  xSemaphoreGive(bus->lock);
+
+  ESP_LOGW(TAG, "Recuperacao #%lu do barramento %d em %lld us: %s", (unsigned long)bus->recovery_count, bus->index,
+           (long long)elapsed_us, recovered ? "ok" : "falhou, nova tentativa na proxima verificacao");
+  if (!recovered)
+  {
+    return;
+  }
+
+  // As pecas podem ter perdido a configuracao; cada driver refaz a sua pelo arbitro
+  for (int i = 0; i < I2C_MAX_DEVICES; i++)
+  {
+    if (i2c_devices[i].in_use && i2c_devices[i].bus == bus && i2c_devices[i].desc.reinit != NULL)
+    {
+      esp_err_t reinit_ret = i2c_devices[i].desc.reinit();
+      if (reinit_ret != ESP_OK)
+      {
+        ESP_LOGE(TAG, "Dispositivo 0x%02X nao reinicializou: %s", i2c_devices[i].desc.addr, esp_err_to_name(reinit_ret));
+      }
+    }
+  }
+}
+
+void i2c_recover_bus(void)
+{
+  for (int b = 0; b < I2C_MAX_BUSES; b++)
+  {
+    if (i2c_buses[b].in_use)
+    {
+      i2c_bus_recover(&i2c_buses[b]);
+    }
+  }
+}
+
+esp_err_t check_i2c(void)
+{
+  esp_err_t result = ESP_OK;
+
+  for (int i = 0; i < I2C_MAX_DEVICES; i++)
+  {
+    struct i2c_device *dev = &i2c_devices[i];
+    if (!dev->in_use || dev->handle == NULL)
+    {
+      continue;
+    }
+    xSemaphoreTake(dev->bus->lock, portMAX_DELAY);
+    esp_err_t ret = i2c_device_probe(dev);
+    i2c_update_state(dev->bus, ret);
+    xSemaphoreGive(dev->bus->lock);
+    if (ret != ESP_OK && result == ESP_OK)
+    {
+      result = ret;
+    }
+  }
+  return result;
+}
+
+void check_and_recover_i2c_if_needed(void)
+{
+  for (int b = 0; b < I2C_MAX_BUSES; b++)
+  {
+    struct i2c_bus *bus = &i2c_buses[b];
+    if (!bus->in_use)
+    {
+      continue;
+    }
+
+    if (bus->state == I2C_STATE_STUCK || !i2c_bus_active(bus))
+    {
+      i2c_bus_recover(bus);
+    }
+    else if (bus->state == I2C_STATE_ACTIVE && bus->transfer_count == bus->last_transfer_count)
+    {
+      bus->state = I2C_STATE_SLEEPING;
+    }
+    bus->last_transfer_count = bus->transfer_count;
+  }
+}
+
+// Acordada por um arbitro quando o barramento trava, ou periodicamente para conferir as linhas
+static void i2c_health_task(void *arg)
+{
+#if I2C_STATS_ENABLED && I2C_STATS_DUMP_PERIOD_MS > 0
+  TickType_t last_dump = xTaskGetTickCount();
+#endif
+
+  while (1)
+  {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(I2C_HEALTH_CHECK_PERIOD_MS));
+    check_and_recover_i2c_if_needed();
+
+#if I2C_STATS_ENABLED && I2C_STATS_DUMP_PERIOD_MS > 0
+    if (xTaskGetTickCount() - last_dump >= pdMS_TO_TICKS(I2C_STATS_DUMP_PERIOD_MS))
+    {
+      last_dump = xTaskGetTickCount();
+      i2c_dump_stats();
+    }
+#endif
+  }
+}
+
+uint32_t i2c_get_recovery_count(void)
+{
+  uint32_t total = 0;
+  for (int b = 0; b < I2C_MAX_BUSES; b++)
+  {
+    total += i2c_buses[b].recovery_count;
+  }
+  return total;
+}
+
+void i2c_get_queue_stats(i2c_priority_t priority, i2c_queue_stats_t *out)
+{
+  if (out == NULL || priority >= I2C_PRIORITY_COUNT)
+  {
+    return;
+  }
+
+  // Soma os barramentos; cada um so e escrito pelo proprio arbitro
+  memset(out, 0, sizeof(*out));
+  for (int b = 0; b < I2C_MAX_BUSES; b++)
+  {
+    const i2c_queue_stats_t *stats = &i2c_buses[b].queue_stats[priority];
+    out->transactions += stats->transactions;
+    out->chunks += stats->chunks;
+    out->total_wait_us += stats->total_wait_us;
+    if (stats->max_wait_us > out->max_wait_us)
+    {
+      out->max_wait_us = stats->max_wait_us;
+    }
+  }
+}
+
+void i2c_reset_queue_stats(void)
+{
+  for (int b = 0; b < I2C_MAX_BUSES; b++)
+  {
+    memset(i2c_buses[b].queue_stats, 0, sizeof(i2c_buses[b].queue_stats));
+  }
+}
+
+#if I2C_STATS_ENABLED
+esp_err_t i2c_get_device_stats(uint8_t addr, i2c_device_stats_t *out)
+{
+  if (out == NULL)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  for (int i = 0; i < I2C_MAX_DEVICES; i++)
+  {
+    if (i2c_devices[i].in_use && i2c_devices[i].desc.addr == addr)
+    {
+      // Copia sob o lock para nao pegar um registro pela metade
+      xSemaphoreTake(i2c_devices[i].bus->lock, portMAX_DELAY);
+      *out = i2c_devices[i].stats;
+      xSemaphoreGive(i2c_devices[i].bus->lock);
+      return ESP_OK;
+    }
+  }
+  return ESP_ERR_NOT_FOUND;
+}
+
+void i2c_reset_device_stats(void)
+{
+  for (int i = 0; i < I2C_MAX_DEVICES; i++)
+  {
+    if (!i2c_devices[i].in_use)
+    {
+      continue;
+    }
+    xSemaphoreTake(i2c_devices[i].bus->lock, portMAX_DELAY);
+    memset(&i2c_devices[i].stats, 0, sizeof(i2c_devices[i].stats));
+    xSemaphoreGive(i2c_devices[i].bus->lock);
+  }
+}
+
+void i2c_dump_stats(void)
+{
+  for (int i = 0; i < I2C_MAX_DEVICES; i++)
+  {
+    if (!i2c_devices[i].in_use)
+    {
+      continue;
+    }
+
+    i2c_device_stats_t stats;
+    i2c_get_device_stats(i2c_devices[i].desc.addr, &stats);
+    ESP_LOGI(TAG, "0x%02X: %lu transacoes, %lu bytes, %lu erros, %lu timeouts, max %lu us",
+             i2c_devices[i].desc.addr, (unsigned long)stats.transactions, (unsigned long)stats.bytes,
+             (unsigned long)stats.errors, (unsigned long)stats.timeouts, (unsigned long)stats.max_latency_us);
+
+    // Uma linha so com os buckets nao vazios, no formato "<limite us:contagem"
+    char line[I2C_STATS_BUCKETS * 20];
+    int len = 0;
+    for (int b = 0; b < I2C_STATS_BUCKETS && len < (int)sizeof(line); b++)
+    {
+      if (stats.latency_hist[b] == 0)
+      {
+        continue;
+      }
+      const char *fmt = (b == I2C_STATS_BUCKETS - 1) ? " >=%lu:%lu" : " <%lu:%lu";
+      unsigned long limit = (b == I2C_STATS_BUCKETS - 1) ? (1UL << (b - 1)) : (1UL << b);
+      len += snprintf(line + len, sizeof(line) - len, fmt, limit, (unsigned long)stats.latency_hist[b]);
+    }
+    if (len > 0)
+    {
+      ESP_LOGI(TAG, "0x%02X latencia us:%s", i2c_devices[i].desc.addr, line);
+    }
+  }
+}
+#endif
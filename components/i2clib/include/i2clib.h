@@ -1,27 +1,161 @@
 #ifndef I2CLIB_H
 #define I2CLIB_H
 
-#include "driver/i2c.h"
+#include "driver/i2c_master.h"
 #include "esp_event.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 #define NOTIF_STOP (1UL << 0)
+#define NOTIF_I2C_DONE (1UL << 1)   // setado no indice I2C_ASYNC_NOTIFY_INDEX da tarefa que submeteu uma requisicao assincrona
 
 #define I2C_MASTER_SCL_IO           9
 #define I2C_MASTER_SDA_IO           8
 #define I2C_MASTER_NUM              0   
 #define I2C_MASTER_FREQ_HZ          100000 
-#define I2C_MASTER_TX_BUF_DISABLE   0
-#define I2C_MASTER_RX_BUF_DISABLE   0
-#define I2C_MASTER_TIMEOUT_MS       1000
+#define I2C_MASTER_GLITCH_IGNORE    7
+
+// Segundo controlador do S3, para placas com o display em pinos proprios
+#define I2C_SECONDARY_NUM           1
+#define I2C_SECONDARY_SDA_IO        4
+#define I2C_SECONDARY_SCL_IO        5
+
+#define I2C_MAX_BUSES               2
+#define I2C_BUS_PRIMARY             0
+#define I2C_BUS_SECONDARY           1
+#define I2C_DEFAULT_TIMEOUT_MS      20  // prazo de cada transacao quando o descritor nao define outro
+
+#define I2C_SPEED_STANDARD_HZ       100000
+#define I2C_SPEED_FAST_HZ           400000
+#define I2C_SPEED_FAST_PLUS_HZ      1000000
+#define I2C_SPEED_SAFE_HZ           I2C_SPEED_STANDARD_HZ
+
+#define I2C_MAX_DEVICES             4
+#define I2C_FALLBACK_ERROR_COUNT    3   // erros seguidos antes de voltar para I2C_SPEED_SAFE_HZ
+#define I2C_PROBE_ACK_ONLY          -1  // a negociacao so escreve o byte 0x00 e confere o ACK
+
+#define I2C_ARBITER_TASK_PRIORITY   10
+#define I2C_ARBITER_TASK_STACK      3072
+#define I2C_ARBITER_TASK_CORE       tskNO_AFFINITY
+#define I2C_QUEUE_LENGTH            8   // transacoes pendentes por prioridade
+#define I2C_NOTIFY_INDEX            1   // indice de notificacao usado para devolver o resultado a quem chamou
+#define I2C_ASYNC_NOTIFY_INDEX      3   // indice so das requisicoes assincronas; o 0 e o contador de outras tarefas
+#define I2C_REQUEST_HEAD_MAX        4   // cabecalhos ate este tamanho sao copiados para a requisicao
+
+#define I2C_HEALTH_TASK_PRIORITY    9
+#define I2C_HEALTH_TASK_STACK       3072
+#define I2C_HEALTH_CHECK_PERIOD_MS  500
+#define I2C_RECOVERY_CLOCK_PULSES   9   // pulsos em SCL para um escravo soltar SDA no meio de um byte
+
+// Instrumentacao por dispositivo; compilar com -DI2C_STATS_ENABLED=0 remove tudo
+#ifndef I2C_STATS_ENABLED
+#define I2C_STATS_ENABLED           1
+#endif
+#define I2C_STATS_BUCKETS           16      // histograma log2 de latencia, de <1 us ate >=16 ms
+#define I2C_STATS_DUMP_PERIOD_MS    10000   // 0 desliga o despejo periodico no console
 
 #define MPU6050_ADDR                0x68    
 #define SSD1306_I2C_ADDR            0x3C  
 
+typedef struct {
+    i2c_port_num_t port;
+    int sda_io;
+    int scl_io;
+} i2c_bus_pins_t;
+
+typedef enum {
+    I2C_PRIORITY_HIGH = 0,          // leituras curtas de sensores, passam na frente
+    I2C_PRIORITY_LOW,               // escritas grandes, como o framebuffer do display
+    I2C_PRIORITY_COUNT
+} i2c_priority_t;
+
+typedef struct {
+    uint8_t addr;
+    uint32_t max_speed_hz;          // maior velocidade suportada pela peca
+    int16_t probe_reg;              // registrador lido na negociacao, ou I2C_PROBE_ACK_ONLY
+    uint8_t probe_value;            // valor esperado em probe_reg
+    i2c_priority_t priority;
+    size_t chunk_size;              // maior bloco de dados por transacao, com o cabecalho repetido (0 = sem divisao)
+    uint32_t timeout_ms;            // prazo de cada transacao (0 = I2C_DEFAULT_TIMEOUT_MS)
+    esp_err_t (*reinit)(void);      // reconfigura a peca depois de uma recuperacao do barramento
+} i2c_device_desc_t;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t chunks;
+    uint64_t total_wait_us;         // soma do tempo entre enfileirar e comecar a transacao
+    uint32_t max_wait_us;
+} i2c_queue_stats_t;
+
+typedef struct {
+    uint32_t transactions;          // transacoes no barramento, contando cada bloco
+    uint32_t bytes;
+    uint32_t errors;
+    uint32_t timeouts;
+    uint32_t max_latency_us;
+    uint32_t latency_hist[I2C_STATS_BUCKETS];   // bucket n: latencia abaixo de 2^n us
+} i2c_device_stats_t;
+
+typedef struct i2c_device *i2c_device_handle_t;
+
+typedef struct i2c_request i2c_request_t;
+typedef void (*i2c_done_cb_t)(i2c_request_t *req, void *arg);
+
+// Uma transacao na fila do arbitro. Nas chamadas assincronas pertence a quem chamou e
+// precisa continuar valida ate i2c_request_done; os campos sao internos ao i2clib.
+struct i2c_request {
+    i2c_device_handle_t dev;
+    const uint8_t *head;
+    size_t head_len;
+    const uint8_t *data;
+    size_t data_len;
+    uint8_t *read_buf;
+    size_t read_len;
+    uint8_t head_copy[I2C_REQUEST_HEAD_MAX];
+    size_t offset;                  // dados ja enviados quando a escrita e dividida em blocos
+    bool started;
+    bool async;
+    volatile bool pending;
+    int64_t queued_us;
+    TaskHandle_t waiter;
+    i2c_done_cb_t cb;
+    void *cb_arg;
+    esp_err_t ret;
+};
+
 esp_err_t i2c_init(void);
+esp_err_t i2c_bus_init(int bus, const i2c_bus_pins_t *pins);
+bool i2c_bus_detect(const i2c_bus_pins_t *pins, uint8_t addr);
+esp_err_t i2c_bind_device(uint8_t addr, int bus);
+int i2c_get_device_bus(uint8_t addr);
 void i2c_scan(void);
 bool i2c_check_bus_active(void);
 void i2c_recover_bus(void);
 void check_and_recover_i2c_if_needed(void);
 esp_err_t check_i2c(void);
 
+esp_err_t i2c_device_register(const i2c_device_desc_t *desc, i2c_device_handle_t *out_handle);
+esp_err_t i2c_device_transmit(i2c_device_handle_t dev, const uint8_t *head, size_t head_len, const uint8_t *data, size_t data_len);
+esp_err_t i2c_device_write_read(i2c_device_handle_t dev, const uint8_t *write_buf, size_t write_len, uint8_t *read_buf, size_t read_len);
+esp_err_t i2c_device_transmit_async(i2c_device_handle_t dev, i2c_request_t *req, const uint8_t *head, size_t head_len,
+                                    const uint8_t *data, size_t data_len, i2c_done_cb_t cb, void *cb_arg);
+esp_err_t i2c_device_write_read_async(i2c_device_handle_t dev, i2c_request_t *req, const uint8_t *write_buf, size_t write_len,
+                                      uint8_t *read_buf, size_t read_len, i2c_done_cb_t cb, void *cb_arg);
+bool i2c_request_done(const i2c_request_t *req);
+esp_err_t i2c_request_wait(i2c_request_t *req, TickType_t ticks_to_wait);
+uint32_t i2c_get_device_speed(uint8_t addr);
+uint32_t i2c_get_recovery_count(void);
+void i2c_get_queue_stats(i2c_priority_t priority, i2c_queue_stats_t *out);
+void i2c_reset_queue_stats(void);
+
+#if I2C_STATS_ENABLED
+esp_err_t i2c_get_device_stats(uint8_t addr, i2c_device_stats_t *out);
+void i2c_reset_device_stats(void);
+void i2c_dump_stats(void);
+#else
+static inline esp_err_t i2c_get_device_stats(uint8_t addr, i2c_device_stats_t *out) { return ESP_ERR_NOT_SUPPORTED; }
+static inline void i2c_reset_device_stats(void) {}
+static inline void i2c_dump_stats(void) {}
+#endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "bias.h"
+#include <math.h>
+#include <string.h>
+
+#define BIAS_DEG_TO_RAD             0.017453292f
+
+static bias_estimate_t bias_state;
+static float bias_reference_g[3];      // gravidade da calibracao guardada
+static float bias_reference_norm;
+static float bias_gate_cos;
+static float bias_accel_mean[3];
+static float bias_accel_var;
+static float bias_still_s;
+static bool bias_seeded = false;
+
+void bias_init(const float gyro_bias_dps[3], const float accel_offset_g[3], float confidence)
+{
+    memset(&bias_state, 0, sizeof(bias_state));
+    for (int i = 0; i < 3; i++)
+    {
+        bias_state.gyro_bias_dps[i] = gyro_bias_dps ? gyro_bias_dps[i] : 0.0f;
+        bias_state.accel_offset_g[i] = accel_offset_g ? accel_offset_g[i] : 0.0f;
+    }
+    memcpy(bias_reference_g, bias_state.accel_offset_g, sizeof(bias_reference_g));
+    bias_reference_norm = sqrtf(bias_reference_g[0] * bias_reference_g[0] + bias_reference_g[1] * bias_reference_g[1] +
+                                bias_reference_g[2] * bias_reference_g[2]);
+    bias_gate_cos = cosf(BIAS_ACCEL_GATE_DEG * BIAS_DEG_TO_RAD);
+    bias_state.confidence = confidence;
+    bias_still_s = 0.0f;
+    bias_seeded = false;
+}
+
+// Uma placa segurada inclinada tambem fica parada; se o offset seguisse essa media, a
+// inclinacao que os jogos leem iria a zero. Sem calibracao nao ha referencia e ele nao anda.
+static bool bias_near_reference(const float mean_g[3])
+{
+    if (bias_reference_norm <= 0.0f)
+    {
+        return false;
+    }
+
+    float dot = 0.0f;
+    float norm2 = 0.0f;
+    for (int i = 0; i < 3; i++)
+    {
+        dot += mean_g[i] * bias_reference_g[i];
+        norm2 += mean_g[i] * mean_g[i];
+    }
+    return dot > 0.0f && dot * dot >= bias_gate_cos * bias_gate_cos * norm2 * bias_reference_norm * bias_reference_norm;
+}
+
+// gyro_dps chega sem correcao; roda a cada amostra, sem acesso ao barramento
+void bias_update(const float accel_g[3], const float gyro_dps[3], float dt, bias_estimate_t *out)
+{
+    if (!bias_seeded)
+    {
+        memcpy(bias_accel_mean, accel_g, sizeof(bias_accel_mean));
+        bias_accel_var = BIAS_STILL_ACCEL_VAR_G2;
+        bias_seeded = true;
+    }
+
+    float k = dt / BIAS_VARIANCE_TAU_S;
+    float dev = 0.0f;
+    for (int i = 0; i < 3; i++)
+    {
+        float d = accel_g[i] - bias_accel_mean[i];
+        bias_accel_mean[i] += d * k;
+        dev += d * d;
+    }
+    bias_accel_var += (dev - bias_accel_var) * k;
+
+    float rate = 0.0f;
+    for (int i = 0; i < 3; i++)
+    {
+        float w = gyro_dps[i] - bias_state.gyro_bias_dps[i];
+        rate += w * w;
+    }
+
+    bool still = rate < BIAS_STILL_GYRO_DPS * BIAS_STILL_GYRO_DPS && bias_accel_var < BIAS_STILL_ACCEL_VAR_G2;
+    bias_still_s = still ? bias_still_s + dt : 0.0f;
+    bias_state.stationary = bias_still_s * 1000.0f >= BIAS_STILL_MIN_MS;
+
+    if (bias_state.stationary)
+    {
+        float kg = dt / BIAS_GYRO_TAU_S;
+        float ka = bias_near_reference(bias_accel_mean) ? dt / BIAS_ACCEL_TAU_S : 0.0f;
+        for (int i = 0; i < 3; i++)
+        {
+            bias_state.gyro_bias_dps[i] += (gyro_dps[i] - bias_state.gyro_bias_dps[i]) * kg;
+            bias_state.accel_offset_g[i] += (bias_accel_mean[i] - bias_state.accel_offset_g[i]) * ka;
+        }
+        bias_state.confidence += (1.0f - bias_state.confidence) * dt / BIAS_CONFIDENCE_TAU_S;
+    }
+    else
+    {
+        bias_state.confidence -= bias_state.confidence * dt / BIAS_CONFIDENCE_DECAY_S;
+    }
+
+    *out = bias_state;
+}
@@ -0,0 +1,215 @@
+#include "fusion.h"
+#include <math.h>
+#include <stdbool.h>
+
+#define FUSION_DEG_TO_RAD           0.017453292f
+#define FUSION_RAD_TO_DEG           57.29578f
+
+static fusion_algorithm_t fusion_algorithm = FUSION_COMPLEMENTARY;
+static bool fusion_seeded = false;
+static int64_t fusion_last_us = 0;
+
+// Complementar: vetor gravidade no referencial do sensor
+static float fusion_gravity[3];
+
+// Mahony e Madgwick: quaternion de orientacao e integral do erro do Mahony
+static float fusion_q[4] = {1.0f, 0.0f, 0.0f, 0.0f};
+static float fusion_integral[3];
+
+static float fusion_inv_norm3(float x, float y, float z)
+{
+    float norm = sqrtf(x * x + y * y + z * z);
+    return norm > 0.0f ? 1.0f / norm : 0.0f;
+}
+
+static void fusion_normalize_q(void)
+{
+    float norm = sqrtf(fusion_q[0] * fusion_q[0] + fusion_q[1] * fusion_q[1] +
+                       fusion_q[2] * fusion_q[2] + fusion_q[3] * fusion_q[3]);
+    for (int i = 0; i < 4; i++)
+    {
+        fusion_q[i] /= norm;
+    }
+}
+
+// Parte da inclinacao medida pelo acelerometro, com guinada zero
+static void fusion_seed(const float accel_g[3])
+{
+    for (int i = 0; i < 3; i++)
+    {
+        fusion_gravity[i] = accel_g[i];
+        fusion_integral[i] = 0.0f;
+    }
+
+    float roll = atan2f(accel_g[1], accel_g[2]);
+    float pitch = atan2f(-accel_g[0], sqrtf(accel_g[1] * accel_g[1] + accel_g[2] * accel_g[2]));
+    float cr = cosf(roll * 0.5f), sr = sinf(roll * 0.5f);
+    float cp = cosf(pitch * 0.5f), sp = sinf(pitch * 0.5f);
+    fusion_q[0] = cr * cp;
+    fusion_q[1] = sr * cp;
+    fusion_q[2] = cr * sp;
+    fusion_q[3] = -sr * sp;
+    fusion_seeded = true;
+}
+
+// Gira a gravidade estimada pelo giro (dg/dt = -w x g) e puxa em direcao ao acelerometro
+static void fusion_complementary(const float a[3], const float w[3], float dt)
+{
+    float g[3] = {fusion_gravity[0], fusion_gravity[1], fusion_gravity[2]};
+    fusion_gravity[0] = g[0] - (w[1] * g[2] - w[2] * g[1]) * dt;
+    fusion_gravity[1] = g[1] - (w[2] * g[0] - w[0] * g[2]) * dt;
+    fusion_gravity[2] = g[2] - (w[0] * g[1] - w[1] * g[0]) * dt;
+
+    float alpha = dt / (FUSION_TAU_MS / 1000.0f + dt);
+    for (int i = 0; i < 3; i++)
+    {
+        fusion_gravity[i] += (a[i] - fusion_gravity[i]) * alpha;
+    }
+}
+
+static void fusion_mahony(const float a[3], const float w[3], float dt)
+{
+    float *q = fusion_q;
+    float gx = w[0], gy = w[1], gz = w[2];
+    float inv = fusion_inv_norm3(a[0], a[1], a[2]);
+
+    if (inv > 0.0f)
+    {
+        float ax = a[0] * inv, ay = a[1] * inv, az = a[2] * inv;
+
+        // Metade da gravidade prevista pelo quaternion e o erro contra a medida
+        float hvx = q[1] * q[3] - q[0] * q[2];
+        float hvy = q[0] * q[1] + q[2] * q[3];
+        float hvz = q[0] * q[0] - 0.5f + q[3] * q[3];
+        float hex = ay * hvz - az * hvy;
+        float hey = az * hvx - ax * hvz;
+        float hez = ax * hvy - ay * hvx;
+
+        if (FUSION_MAHONY_KI > 0.0f)
+        {
+            fusion_integral[0] += 2.0f * FUSION_MAHONY_KI * hex * dt;
+            fusion_integral[1] += 2.0f * FUSION_MAHONY_KI * hey * dt;
+            fusion_integral[2] += 2.0f * FUSION_MAHONY_KI * hez * dt;
+            gx += fusion_integral[0];
+            gy += fusion_integral[1];
+            gz += fusion_integral[2];
+        }
+        gx += 2.0f * FUSION_MAHONY_KP * hex;
+        gy += 2.0f * FUSION_MAHONY_KP * hey;
+        gz += 2.0f * FUSION_MAHONY_KP * hez;
+    }
+
+    gx *= 0.5f * dt;
+    gy *= 0.5f * dt;
+    gz *= 0.5f * dt;
+    float qa = q[0], qb = q[1], qc = q[2];
+    q[0] += -qb * gx - qc * gy - q[3] * gz;
+    q[1] += qa * gx + qc * gz - q[3] * gy;
+    q[2] += qa * gy - qb * gz + q[3] * gx;
+    q[3] += qa * gz + qb * gy - qc * gx;
+    fusion_normalize_q();
+}
+
+static void fusion_madgwick(const float a[3], const float w[3], float dt)
+{
+    float *q = fusion_q;
+    float gx = w[0], gy = w[1], gz = w[2];
+
+    float qd0 = 0.5f * (-q[1] * gx - q[2] * gy - q[3] * gz);
+    float qd1 = 0.5f * (q[0] * gx + q[2] * gz - q[3] * gy);
+    float qd2 = 0.5f * (q[0] * gy - q[1] * gz + q[3] * gx);
+    float qd3 = 0.5f * (q[0] * gz + q[1] * gy - q[2] * gx);
+
+    float inv = fusion_inv_norm3(a[0], a[1], a[2]);
+    if (inv > 0.0f)
+    {
+        float ax = a[0] * inv, ay = a[1] * inv, az = a[2] * inv;
+        float q0q0 = q[0] * q[0], q1q1 = q[1] * q[1], q2q2 = q[2] * q[2], q3q3 = q[3] * q[3];
+
+        // Passo do gradiente descendente sobre o erro da gravidade
+        float s0 = 4.0f * q[0] * q2q2 + 2.0f * q[2] * ax + 4.0f * q[0] * q1q1 - 2.0f * q[1] * ay;
+        float s1 = 4.0f * q[1] * q3q3 - 2.0f * q[3] * ax + 4.0f * q0q0 * q[1] - 2.0f * q[0] * ay - 4.0f * q[1] +
+                   8.0f * q[1] * q1q1 + 8.0f * q[1] * q2q2 + 4.0f * q[1] * az;
+        float s2 = 4.0f * q0q0 * q[2] + 2.0f * q[0] * ax + 4.0f * q[2] * q3q3 - 2.0f * q[3] * ay - 4.0f * q[2] +
+                   8.0f * q[2] * q1q1 + 8.0f * q[2] * q2q2 + 4.0f * q[2] * az;
+        float s3 = 4.0f * q1q1 * q[3] - 2.0f * q[1] * ax + 4.0f * q2q2 * q[3] - 2.0f * q[2] * ay;
+        float norm = sqrtf(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+        if (norm > 0.0f)
+        {
+            qd0 -= FUSION_MADGWICK_BETA * s0 / norm;
+            qd1 -= FUSION_MADGWICK_BETA * s1 / norm;
+            qd2 -= FUSION_MADGWICK_BETA * s2 / norm;
+            qd3 -= FUSION_MADGWICK_BETA * s3 / norm;
+        }
+    }
+
+    q[0] += qd0 * dt;
+    q[1] += qd1 * dt;
+    q[2] += qd2 * dt;
+    q[3] += qd3 * dt;
+    fusion_normalize_q();
+}
+
+void fusion_init(fusion_algorithm_t algorithm)
+{
+    fusion_algorithm = algorithm;
+    fusion_seeded = false;
+}
+
+// Roda a cada amostra do sensor; a primeira amostra, ou uma depois de um buraco, so
+// reinicia a estimativa
+void fusion_update(const float accel_g[3], const float gyro_dps[3], int64_t timestamp_us, fusion_state_t *out)
+{
+    int64_t dt_us = timestamp_us - fusion_last_us;
+    fusion_last_us = timestamp_us;
+
+    if (!fusion_seeded || dt_us <= 0 || dt_us > FUSION_MAX_DT_MS * 1000)
+    {
+        fusion_seed(accel_g);
+    }
+    else
+    {
+        float dt = dt_us * 1e-6f;
+        float w[3] = {gyro_dps[0] * FUSION_DEG_TO_RAD, gyro_dps[1] * FUSION_DEG_TO_RAD, gyro_dps[2] * FUSION_DEG_TO_RAD};
+
+        switch (fusion_algorithm)
+        {
+        case FUSION_MAHONY:
+            fusion_mahony(accel_g, w, dt);
+            break;
+        case FUSION_MADGWICK:
+            fusion_madgwick(accel_g, w, dt);
+            break;
+        default:
+            fusion_complementary(accel_g, w, dt);
+            break;
+        }
+    }
+
+    float g[3];
+    if (fusion_algorithm == FUSION_COMPLEMENTARY)
+    {
+        // Mantem o modulo de 1 g; so a direcao vem do filtro
+        float inv = fusion_inv_norm3(fusion_gravity[0], fusion_gravity[1], fusion_gravity[2]);
+        g[0] = fusion_gravity[0] * inv;
+        g[1] = fusion_gravity[1] * inv;
+        g[2] = fusion_gravity[2] * inv;
+    }
+    else
+    {
+        const float *q = fusion_q;
+        g[0] = 2.0f * (q[1] * q[3] - q[0] * q[2]);
+        g[1] = 2.0f * (q[0] * q[1] + q[2] * q[3]);
+        g[2] = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        out->gravity_g[i] = g[i];
+        out->linear_accel_g[i] = accel_g[i] - g[i];
+    }
+    out->roll_deg = atan2f(g[1], g[2]) * FUSION_RAD_TO_DEG;
+    out->pitch_deg = atan2f(-g[0], sqrtf(g[1] * g[1] + g[2] * g[2])) * FUSION_RAD_TO_DEG;
+    out->yaw_rate_dps = gyro_dps[0] * g[0] + gyro_dps[1] * g[1] + gyro_dps[2] * g[2];
+    out->timestamp_us = timestamp_us;
+}
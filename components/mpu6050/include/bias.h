@@ -0,0 +1,28 @@
+#ifndef BIAS_H
+#define BIAS_H
+
+#include <stdbool.h>
+
+// Estimativa continua do vies, atualizada so quando a placa esta parada: giro quase
+// zero e pouca variancia no acelerometro por BIAS_STILL_MIN_MS
+#define BIAS_STILL_GYRO_DPS         3.0f
+#define BIAS_STILL_ACCEL_VAR_G2     0.001f  // soma das variancias dos tres eixos
+#define BIAS_STILL_MIN_MS           500
+#define BIAS_VARIANCE_TAU_S         0.2f
+#define BIAS_GYRO_TAU_S             5.0f
+#define BIAS_ACCEL_TAU_S            30.0f
+#define BIAS_ACCEL_GATE_DEG         3.0f    // o offset so anda perto da gravidade da calibracao
+#define BIAS_CONFIDENCE_TAU_S       10.0f
+#define BIAS_CONFIDENCE_DECAY_S     300.0f
+
+typedef struct {
+    float gyro_bias_dps[3];
+    float accel_offset_g[3];        // so segue a media parada perto da calibracao, nunca uma pausa inclinada
+    float confidence;               // 0 sem estimativa, 1 depois de ~30 s parada
+    bool stationary;
+} bias_estimate_t;
+
+void bias_init(const float gyro_bias_dps[3], const float accel_offset_g[3], float confidence);
+void bias_update(const float accel_g[3], const float gyro_dps[3], float dt, bias_estimate_t *out);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef FUSION_H
+#define FUSION_H
+
+#include <stdint.h>
+
+// Estimativa de orientacao a partir do giroscopio e do acelerometro. O giro entra sem
+// atraso; o acelerometro so corrige a deriva, com constante de tempo FUSION_TAU_MS.
+// A latencia de uma estimativa e portanto a idade da amostra que a gerou.
+#define FUSION_TAU_MS               250     // filtro complementar
+#define FUSION_MAHONY_KP            1.0f
+#define FUSION_MAHONY_KI            0.0f
+#define FUSION_MADGWICK_BETA        0.1f
+#define FUSION_MAX_DT_MS            100     // buracos maiores reiniciam a estimativa pelo acelerometro
+
+typedef enum {
+    FUSION_COMPLEMENTARY = 0,
+    FUSION_MAHONY,
+    FUSION_MADGWICK
+} fusion_algorithm_t;
+
+typedef struct {
+    float pitch_deg;
+    float roll_deg;
+    float yaw_rate_dps;             // rotacao em torno da vertical
+    float gravity_g[3];             // gravidade estimada no referencial do sensor
+    float linear_accel_g[3];        // aceleracao medida sem a gravidade
+    int64_t timestamp_us;
+} fusion_state_t;
+
+void fusion_init(fusion_algorithm_t algorithm);
+void fusion_update(const float accel_g[3], const float gyro_dps[3], int64_t timestamp_us, fusion_state_t *out);
+
+#endif
@@ -5,50 +5,125 @@
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "driver/i2c.h"
 #include "esp_err.h"
+#include "driver/gpio.h"
 #include "i2clib.h"
+#include "mpu6050_types.h"
 
-#define MPU6050_PWR_MGMT_1          0x6B    
-#define MPU6050_SMPLRT_DIV          0x19   
-#define MPU6050_CONFIG              0x1A   
-#define MPU6050_GYRO_CONFIG         0x1B    
-#define MPU6050_ACCEL_CONFIG        0x1C   
-#define MPU6050_WHO_AM_I            0x75   
-
-#define MPU6050_ACCEL_XOUT_H        0x3B
-#define MPU6050_ACCEL_XOUT_L        0x3C
-#define MPU6050_ACCEL_YOUT_H        0x3D
-#define MPU6050_ACCEL_YOUT_L        0x3E
-#define MPU6050_ACCEL_ZOUT_H        0x3F
-#define MPU6050_ACCEL_ZOUT_L        0x40
-#define MPU6050_TEMP_OUT_H          0x41
-#define MPU6050_TEMP_OUT_L          0x42
-#define MPU6050_GYRO_XOUT_H         0x43
-#define MPU6050_GYRO_XOUT_L         0x44
-#define MPU6050_GYRO_YOUT_H         0x45
-#define MPU6050_GYRO_YOUT_L         0x46
-#define MPU6050_GYRO_ZOUT_H         0x47
-#define MPU6050_GYRO_ZOUT_L         0x48
+#define MPU6050_TIMEOUT_MS          20  // uma rajada da FIFO de 140 bytes leva ~13 ms a 100 kHz
+#define MPU6050_MAX_SPEED_HZ        I2C_SPEED_FAST_HZ
 
+// Amostragem por interrupcao de dado pronto
+// Pino ligado ao INT da peca; -1 quando nao esta ligado. A placa que liga o INT define o
+// pino na compilacao, por exemplo -DMPU6050_INT_GPIO=7
+#ifndef MPU6050_INT_GPIO
+#define MPU6050_INT_GPIO            -1
+#endif
+#define MPU6050_INT_TIMEOUT_MS      100     // sem pulso neste prazo a tarefa faz uma leitura periodica
+#define MPU6050_INT_MAX_MISSES      10      // prazos seguidos sem pulso ate desistir do INT
+#define MPU6050_SAMPLING_TASK_PRIORITY  11  // acima do arbitro, para ler logo apos o pulso
+#define MPU6050_SAMPLING_TASK_STACK     3072
+#define MPU6050_DEFAULT_RATE_HZ     1000
+
+// Conversao em ponto fixo Q16 (1.0 = 65536); a escala do acelerometro (+-2 g) e exata,
+// giroscopio e temperatura usam reciproco inteiro com erro relativo abaixo de 1e-5
+#define MPU6050_Q16_ONE             65536
+#define MPU6050_Q16_TO_FLOAT(q)     ((float)(q) * (1.0f / MPU6050_Q16_ONE))
+#define MPU6050_FLOAT_TO_Q16(f)     ((int32_t)((f) * MPU6050_Q16_ONE))
+#define MPU6050_ATAN_LUT_BITS       6       // 64 segmentos interpolados de atan em [0, 1]
+
+#define MPU6050_FIFO_BURST_SAMPLES  10      // amostras por transacao ao esvaziar a FIFO
+
+// Banda do filtro passa-baixa interno (DLPF_CFG); o atraso cresce conforme a banda cai
+typedef enum {
+    MPU6050_DLPF_OFF = 0,           // 260 Hz, 0 ms
+    MPU6050_DLPF_184HZ,             // 2 ms
+    MPU6050_DLPF_94HZ,              // 3 ms
+    MPU6050_DLPF_44HZ,              // 5 ms
+    MPU6050_DLPF_21HZ,              // 8.5 ms
+    MPU6050_DLPF_10HZ,              // 13.8 ms
+    MPU6050_DLPF_5HZ                // 19 ms
+} mpu6050_dlpf_t;
+
+// Cada passo dobra o fundo de escala e divide a resolucao por dois
+typedef enum {
+    MPU6050_ACCEL_2G = 0,           // 16384 LSB/g
+    MPU6050_ACCEL_4G,
+    MPU6050_ACCEL_8G,
+    MPU6050_ACCEL_16G
+} mpu6050_accel_range_t;
+
+typedef enum {
+    MPU6050_GYRO_250DPS = 0,        // 131 LSB/dps
+    MPU6050_GYRO_500DPS,
+    MPU6050_GYRO_1000DPS,
+    MPU6050_GYRO_2000DPS
+} mpu6050_gyro_range_t;
+
+typedef struct {
+    const char *name;
+    uint32_t sample_rate_hz;
+    mpu6050_dlpf_t dlpf;
+    mpu6050_accel_range_t accel_range;
+    mpu6050_gyro_range_t gyro_range;
+} mpu6050_config_t;
+
+extern const mpu6050_config_t MPU6050_PROFILE_LOW_LATENCY;     // 1 kHz sem DLPF, o padrao do mpu6050_init
+extern const mpu6050_config_t MPU6050_PROFILE_BALANCED;        // 250 Hz com DLPF de 94 Hz
+extern const mpu6050_config_t MPU6050_PROFILE_SMOOTH;          // 100 Hz com DLPF de 44 Hz
+extern const mpu6050_config_t MPU6050_PROFILE_HIGH_G;          // 1 kHz, +-16 g e +-2000 dps
+
+typedef struct {
+    int32_t accel_g[3];             // Q16
+    int32_t gyro_dps[3];            // Q16
+    int32_t temp_c;                 // Q16
+} mpu6050_q16_data_t;
+
+typedef struct {
+    uint32_t samples;
+    uint32_t overruns;              // pulsos de dado pronto perdidos antes da leitura
+    uint32_t errors;
+    bool interrupt_driven;          // false quando roda na leitura periodica
+} mpu6050_sampling_stats_t;
+
+// Chamada pela tarefa de amostragem; timestamp_us e o instante do pulso de dado pronto
+typedef void (*mpu6050_sample_cb_t)(const mpu6050_data_t *data, int64_t timestamp_us, void *arg);
+
+// Leitura assincrona de todos os eixos; precisa continuar valida ate ser coletada
 typedef struct {
-    int16_t accel_x;
-    int16_t accel_y;
-    int16_t accel_z;
-    int16_t temp;
-    int16_t gyro_x;
-    int16_t gyro_y;
-    int16_t gyro_z;
-} mpu6050_data_t;
+    i2c_request_t req;
+    uint8_t buffer[14];
+} mpu6050_read_op_t;
 
 esp_err_t i2c_master_init(void);
 esp_err_t mpu6050_write_byte(uint8_t reg_addr, uint8_t data);
 esp_err_t mpu6050_read_byte(uint8_t reg_addr, uint8_t *data);
 esp_err_t mpu6050_read_bytes(uint8_t reg_addr, uint8_t *data, size_t len);
+esp_err_t mpu6050_read_bytes_async(uint8_t reg_addr, uint8_t *data, size_t len, i2c_request_t *req, i2c_done_cb_t cb, void *cb_arg);
 esp_err_t mpu6050_init(void);
+esp_err_t mpu6050_set_config(const mpu6050_config_t *config);
+void mpu6050_set_scale(mpu6050_accel_range_t accel_range, mpu6050_gyro_range_t gyro_range);
+const mpu6050_config_t *mpu6050_get_config(void);
+float mpu6050_accel_lsb_per_g(void);
+float mpu6050_gyro_lsb_per_dps(void);
 esp_err_t mpu6050_read_all(mpu6050_data_t *data);
+esp_err_t mpu6050_read_all_async(mpu6050_read_op_t *op);
+esp_err_t mpu6050_read_all_collect(mpu6050_read_op_t *op, mpu6050_data_t *data, TickType_t ticks_to_wait);
 void mpu6050_convert_data(mpu6050_data_t *raw_data, float *accel_g, float *gyro_dps, float *temp_c);
+void mpu6050_convert_q16(const mpu6050_data_t *raw_data, mpu6050_q16_data_t *out, size_t count);
+int32_t mpu6050_atan2_deg_q16(int32_t y, int32_t x);
 void mpu6050_task(void *pvParameters);
 esp_err_t mpu6050_read_acceleration(float* ax, float* ay, float* az);
+uint32_t mpu6050_get_sample_rate_hz(void);
+esp_err_t mpu6050_set_sample_rate_hz(uint32_t rate_hz);
+esp_err_t mpu6050_start_sampling(int int_gpio, uint32_t rate_hz, mpu6050_sample_cb_t cb, void *cb_arg);
+esp_err_t mpu6050_stop_sampling(void);
+void mpu6050_get_sampling_stats(mpu6050_sampling_stats_t *out);
+esp_err_t mpu6050_fifo_enable(uint8_t channels);
+esp_err_t mpu6050_fifo_disable(void);
+esp_err_t mpu6050_fifo_reset(void);
+esp_err_t mpu6050_fifo_count(uint16_t *bytes);
+esp_err_t mpu6050_fifo_read(mpu6050_data_t *samples, size_t max_samples, size_t *out_count);
+uint32_t mpu6050_get_fifo_overflows(void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef MPU6050_TYPES_H
+#define MPU6050_TYPES_H
+
+#include <stdint.h>
+
+// Separado de mpu6050.h para ser usado sem o driver, como no replay em host Linux e no
+// emulador da peca: mapa de registradores e o formato da amostra bruta
+#define MPU6050_PWR_MGMT_1          0x6B
+#define MPU6050_SMPLRT_DIV          0x19
+#define MPU6050_CONFIG              0x1A
+#define MPU6050_GYRO_CONFIG         0x1B
+#define MPU6050_ACCEL_CONFIG        0x1C
+#define MPU6050_WHO_AM_I            0x75
+#define MPU6050_FIFO_EN             0x23
+#define MPU6050_USER_CTRL           0x6A
+#define MPU6050_FIFO_COUNTH         0x72
+#define MPU6050_FIFO_R_W            0x74
+#define MPU6050_INT_PIN_CFG         0x37
+#define MPU6050_INT_ENABLE          0x38
+#define MPU6050_INT_STATUS          0x3A
+
+#define MPU6050_ACCEL_XOUT_H        0x3B
+#define MPU6050_ACCEL_XOUT_L        0x3C
+#define MPU6050_ACCEL_YOUT_H        0x3D
+#define MPU6050_ACCEL_YOUT_L        0x3E
+#define MPU6050_ACCEL_ZOUT_H        0x3F
+#define MPU6050_ACCEL_ZOUT_L        0x40
+#define MPU6050_TEMP_OUT_H          0x41
+#define MPU6050_TEMP_OUT_L          0x42
+#define MPU6050_GYRO_XOUT_H         0x43
+#define MPU6050_GYRO_XOUT_L         0x44
+#define MPU6050_GYRO_YOUT_H         0x45
+#define MPU6050_GYRO_YOUT_L         0x46
+#define MPU6050_GYRO_ZOUT_H         0x47
+#define MPU6050_GYRO_ZOUT_L         0x48
+
+// Canais gravados na FIFO (bits de FIFO_EN); a peca grava na ordem dos registradores
+#define MPU6050_FIFO_TEMP           (1 << 7)
+#define MPU6050_FIFO_GYRO_X         (1 << 6)
+#define MPU6050_FIFO_GYRO_Y         (1 << 5)
+#define MPU6050_FIFO_GYRO_Z         (1 << 4)
+#define MPU6050_FIFO_ACCEL          (1 << 3)
+#define MPU6050_FIFO_GYRO           (MPU6050_FIFO_GYRO_X | MPU6050_FIFO_GYRO_Y | MPU6050_FIFO_GYRO_Z)
+
+#define MPU6050_USER_CTRL_FIFO_EN       (1 << 6)
+#define MPU6050_USER_CTRL_FIFO_RESET    (1 << 2)
+
+// Mesmos bits em INT_ENABLE e INT_STATUS; ler INT_STATUS limpa todos
+#define MPU6050_INT_DATA_RDY        (1 << 0)
+#define MPU6050_INT_FIFO_OFLOW      (1 << 4)
+
+#define MPU6050_FIFO_SIZE           1024
+#define MPU6050_GYRO_RATE_HZ        8000    // taxa interna com o DLPF desligado (CONFIG = 0)
+#define MPU6050_GYRO_RATE_DLPF_HZ   1000    // taxa interna com qualquer DLPF ligado
+
+typedef struct {
+    int16_t accel_x;
+    int16_t accel_y;
+    int16_t accel_z;
+    int16_t temp;
+    int16_t gyro_x;
+    int16_t gyro_y;
+    int16_t gyro_z;
+} mpu6050_data_t;
+
+#endif
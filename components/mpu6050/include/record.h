@@ -0,0 +1,48 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_err.h"
+#include "mpu6050_types.h"
+
+// Arquivo: cabecalho de RECORD_HEADER_SIZE bytes e depois registros de RECORD_SIZE bytes,
+// tudo little-endian. Cada registro guarda o intervalo desde o anterior em us (u32) e os
+// sete int16 brutos; intervalo 0 marca o inicio de uma nova sessao anexada ao arquivo.
+// Nao depende do driver nem do FreeRTOS, para rodar tambem em host Linux.
+#define RECORD_MAGIC                "MPUR"
+#define RECORD_VERSION              1
+#define RECORD_HEADER_SIZE          16
+#define RECORD_SIZE                 18
+#define RECORD_BUFFER_SIZE          4096    // buffer do stdio; e so isso que fica em RAM
+
+typedef struct {
+    uint32_t sample_rate_hz;
+    uint8_t dlpf;
+    uint8_t accel_range;            // mpu6050_accel_range_t da gravacao
+    uint8_t gyro_range;             // mpu6050_gyro_range_t da gravacao
+} record_info_t;
+
+typedef struct {
+    FILE *file;
+    int64_t last_us;
+    bool session_start;
+    uint32_t count;
+} record_writer_t;
+
+typedef struct {
+    FILE *file;
+    record_info_t info;
+    int64_t timestamp_us;           // relativo ao inicio do arquivo
+} record_reader_t;
+
+esp_err_t record_writer_open(record_writer_t *writer, const char *path, const record_info_t *info);
+esp_err_t record_write(record_writer_t *writer, const mpu6050_data_t *data, int64_t timestamp_us);
+esp_err_t record_writer_close(record_writer_t *writer);
+
+esp_err_t record_reader_open(record_reader_t *reader, const char *path);
+esp_err_t record_read(record_reader_t *reader, mpu6050_data_t *data, int64_t *timestamp_us, bool *session_start);
+void record_reader_close(record_reader_t *reader);
+
+#endif
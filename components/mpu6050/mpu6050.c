@@ -1,84 +1,113 @@
 #include "mpu6050.h"
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
 
-esp_err_t i2c_master_init(void)
-{
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = I2C_MASTER_SDA_IO,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_io_num = I2C_MASTER_SCL_IO,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = I2C_MASTER_FREQ_HZ,
-    };
+static const char *TAG = "MPU6050";
 
-    esp_err_t err = i2c_param_config(I2C_MASTER_NUM, &conf);
-    if (err != ESP_OK)
-    {
-        return err;
-    }
+const mpu6050_config_t MPU6050_PROFILE_LOW_LATENCY = {
+    .name = "LOW LATENCY",
+    .sample_rate_hz = 1000,
+    .dlpf = MPU6050_DLPF_OFF,
+    .accel_range = MPU6050_ACCEL_2G,
+    .gyro_range = MPU6050_GYRO_250DPS,
+};
+
+const mpu6050_config_t MPU6050_PROFILE_BALANCED = {
+    .name = "BALANCED",
+    .sample_rate_hz = 250,
+    .dlpf = MPU6050_DLPF_94HZ,
+    .accel_range = MPU6050_ACCEL_2G,
+    .gyro_range = MPU6050_GYRO_250DPS,
+};
+
+const mpu6050_config_t MPU6050_PROFILE_SMOOTH = {
+    .name = "SMOOTH",
+    .sample_rate_hz = 100,
+    .dlpf = MPU6050_DLPF_44HZ,
+    .accel_range = MPU6050_ACCEL_2G,
+    .gyro_range = MPU6050_GYRO_250DPS,
+};
+
+const mpu6050_config_t MPU6050_PROFILE_HIGH_G = {
+    .name = "HIGH G",
+    .sample_rate_hz = 1000,
+    .dlpf = MPU6050_DLPF_184HZ,
+    .accel_range = MPU6050_ACCEL_16G,
+    .gyro_range = MPU6050_GYRO_2000DPS,
+};
+
+static i2c_device_handle_t mpu6050_dev = NULL;
+
+// Configuracao em uso; mpu6050_configure grava tudo de novo depois de uma recuperacao
+static mpu6050_config_t mpu6050_config;
+static uint8_t mpu6050_smplrt_div = 0x07;
+
+// Amostragem por interrupcao: o ISR so marca o instante e acorda a tarefa
+static TaskHandle_t mpu6050_sampling_task_handle = NULL;
+static int mpu6050_int_gpio = -1;
+static bool mpu6050_int_active = false;
+static volatile int64_t mpu6050_int_timestamp_us = 0;
+static mpu6050_sample_cb_t mpu6050_sample_cb = NULL;
+static void *mpu6050_sample_cb_arg = NULL;
+static mpu6050_sampling_stats_t mpu6050_sampling_stats;
+static atomic_bool mpu6050_sampling_stop = false;
+static SemaphoreHandle_t mpu6050_sampling_done = NULL;
+static StaticSemaphore_t mpu6050_sampling_done_buffer;
 
-    return i2c_driver_install(I2C_MASTER_NUM, conf.mode,
-                              I2C_MASTER_RX_BUF_DISABLE,
-                              I2C_MASTER_TX_BUF_DISABLE, 0);
+// Canais ligados na FIFO (0 = FIFO desligada), refeitos depois de uma recuperacao
+static uint8_t mpu6050_fifo_channels = 0;
+static uint8_t mpu6050_fifo_sample_size = 0;
+static uint32_t mpu6050_fifo_overflows = 0;
+static uint8_t mpu6050_fifo_buffer[MPU6050_FIFO_BURST_SAMPLES * 14];
+
+esp_err_t i2c_master_init(void)
+{
+    return i2c_init();
 }
 
 esp_err_t mpu6050_write_byte(uint8_t reg_addr, uint8_t data)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (MPU6050_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, reg_addr, true);
-    i2c_master_write_byte(cmd, data, true);
-    i2c_master_stop(cmd);
-
-    esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, 1000 / portTICK_PERIOD_MS);
-    i2c_cmd_link_delete(cmd);
-
-    return ret;
+    const uint8_t buffer[2] = {reg_addr, data};
+    return i2c_device_transmit(mpu6050_dev, buffer, sizeof(buffer), NULL, 0);
 }
 
 esp_err_t mpu6050_read_byte(uint8_t reg_addr, uint8_t *data)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (MPU6050_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, reg_addr, true);
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (MPU6050_ADDR << 1) | I2C_MASTER_READ, true);
-    i2c_master_read_byte(cmd, data, I2C_MASTER_NACK);
-    i2c_master_stop(cmd);
-
-    esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, 1000 / portTICK_PERIOD_MS);
-    i2c_cmd_link_delete(cmd);
-
-    return ret;
+    return i2c_device_write_read(mpu6050_dev, &reg_addr, 1, data, 1);
 }
 
 esp_err_t mpu6050_read_bytes(uint8_t reg_addr, uint8_t *data, size_t len)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (MPU6050_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, reg_addr, true);
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (MPU6050_ADDR << 1) | I2C_MASTER_READ, true);
+    return i2c_device_write_read(mpu6050_dev, &reg_addr, 1, data, len);
+}
 
-    if (len > 1)
+// Retorna assim que a leitura entra na fila; data precisa continuar valido ate req terminar
+esp_err_t mpu6050_read_bytes_async(uint8_t reg_addr, uint8_t *data, size_t len, i2c_request_t *req, i2c_done_cb_t cb, void *cb_arg)
+{
+    return i2c_device_write_read_async(mpu6050_dev, req, &reg_addr, 1, data, len, cb, cb_arg);
+}
+
+// Liga o pulso de dado pronto quando o INT esta em uso e o aviso de transbordo quando
+// a FIFO esta ligada
+static esp_err_t mpu6050_write_int_enable(bool data_ready)
+{
+    uint8_t mask = data_ready ? MPU6050_INT_DATA_RDY : 0x00;
+    if (mpu6050_fifo_channels != 0)
     {
-        i2c_master_read(cmd, data, len - 1, I2C_MASTER_ACK);
+        mask |= MPU6050_INT_FIFO_OFLOW;
     }
-    i2c_master_read_byte(cmd, data + len - 1, I2C_MASTER_NACK);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, 1000 / portTICK_PERIOD_MS);
-    i2c_cmd_link_delete(cmd);
-
-    return ret;
+    return mpu6050_write_byte(MPU6050_INT_ENABLE, mask);
 }
 
-esp_err_t mpu6050_init(void)
+// Confere o WHO_AM_I e grava a configuracao. Tambem e chamada pelo i2clib depois de
+// uma recuperacao do barramento, ja que a peca pode ter sido resetada.
+static esp_err_t mpu6050_configure(void)
 {
     esp_err_t ret;
     uint8_t who_am_i;
+
     ret = mpu6050_read_byte(MPU6050_WHO_AM_I, &who_am_i);
     if (ret != ESP_OK)
     {
@@ -98,41 +127,78 @@ esp_err_t mpu6050_init(void)
 
     vTaskDelay(100 / portTICK_PERIOD_MS); 
 
-    ret = mpu6050_write_byte(MPU6050_SMPLRT_DIV, 0x07);
+    ret = mpu6050_write_byte(MPU6050_SMPLRT_DIV, mpu6050_smplrt_div);
     if (ret != ESP_OK)
     {
         return ret;
     }
 
-    ret = mpu6050_write_byte(MPU6050_CONFIG, 0x00);
+    ret = mpu6050_write_byte(MPU6050_CONFIG, mpu6050_config.dlpf);
     if (ret != ESP_OK)
     {
         return ret;
     }
 
-    ret = mpu6050_write_byte(MPU6050_GYRO_CONFIG, 0x00);
+    ret = mpu6050_write_byte(MPU6050_GYRO_CONFIG, mpu6050_config.gyro_range << 3);
     if (ret != ESP_OK)
     {
         return ret;
     }
 
-    ret = mpu6050_write_byte(MPU6050_ACCEL_CONFIG, 0x00);
+    ret = mpu6050_write_byte(MPU6050_ACCEL_CONFIG, mpu6050_config.accel_range << 3);
     if (ret != ESP_OK)
     {
         return ret;
     }
+
+    if (mpu6050_int_active)
+    {
+        // Pulso de 50 us em nivel alto a cada amostra nova
+        ret = mpu6050_write_byte(MPU6050_INT_PIN_CFG, 0x00);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+        ret = mpu6050_write_int_enable(true);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+    }
+
+    if (mpu6050_fifo_channels != 0)
+    {
+        return mpu6050_fifo_enable(mpu6050_fifo_channels);
+    }
     return ESP_OK;
 }
 
-esp_err_t mpu6050_read_all(mpu6050_data_t *data)
+esp_err_t mpu6050_init(void)
 {
-    uint8_t buffer[14];
-    esp_err_t ret = mpu6050_read_bytes(MPU6050_ACCEL_XOUT_H, buffer, 14);
+    const i2c_device_desc_t dev_desc = {
+        .addr = MPU6050_ADDR,
+        .max_speed_hz = MPU6050_MAX_SPEED_HZ,
+        .probe_reg = MPU6050_WHO_AM_I,
+        .probe_value = 0x68,
+        .priority = I2C_PRIORITY_HIGH,
+        .timeout_ms = MPU6050_TIMEOUT_MS,
+        .reinit = mpu6050_configure,
+    };
+    esp_err_t ret = i2c_device_register(&dev_desc, &mpu6050_dev);
     if (ret != ESP_OK)
     {
         return ret;
     }
 
+    if (mpu6050_config.name == NULL)
+    {
+        mpu6050_config = MPU6050_PROFILE_LOW_LATENCY;
+    }
+    return mpu6050_configure();
+}
+
+static void mpu6050_parse_all(const uint8_t *buffer, mpu6050_data_t *data)
+{
     data->accel_x = (int16_t)((buffer[0] << 8) | buffer[1]);
     data->accel_y = (int16_t)((buffer[2] << 8) | buffer[3]);
     data->accel_z = (int16_t)((buffer[4] << 8) | buffer[5]);
@@ -140,35 +206,339 @@ esp_err_t mpu6050_read_all(mpu6050_data_t *data)
     data->gyro_x = (int16_t)((buffer[8] << 8) | buffer[9]);
     data->gyro_y = (int16_t)((buffer[10] << 8) | buffer[11]);
     data->gyro_z = (int16_t)((buffer[12] << 8) | buffer[13]);
+}
 
+esp_err_t mpu6050_read_all(mpu6050_data_t *data)
+{
+    uint8_t buffer[14];
+    esp_err_t ret = mpu6050_read_bytes(MPU6050_ACCEL_XOUT_H, buffer, 14);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    mpu6050_parse_all(buffer, data);
     return ESP_OK;
 }
 
+esp_err_t mpu6050_read_all_async(mpu6050_read_op_t *op)
+{
+    return mpu6050_read_bytes_async(MPU6050_ACCEL_XOUT_H, op->buffer, sizeof(op->buffer), &op->req, NULL, NULL);
+}
+
+// Espera a leitura iniciada por mpu6050_read_all_async e converte o resultado
+esp_err_t mpu6050_read_all_collect(mpu6050_read_op_t *op, mpu6050_data_t *data, TickType_t ticks_to_wait)
+{
+    esp_err_t ret = i2c_request_wait(&op->req, ticks_to_wait);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    mpu6050_parse_all(op->buffer, data);
+    return ESP_OK;
+}
+
+// Reciprocos das escalas em Q16 deslocados para caber em 32 bits com o int16 de entrada:
+// 65536 / 131 * 2^7 e 65536 / 340 * 2^8. Cada faixa acima de +-250 dps divide 131 por
+// dois, entao so tira um bit do deslocamento.
+#define MPU6050_GYRO_Q16_MUL        64035
+#define MPU6050_GYRO_Q16_SHIFT      7
+#define MPU6050_TEMP_Q16_MUL        49345
+#define MPU6050_TEMP_Q16_SHIFT      8
+#define MPU6050_TEMP_Q16_OFFSET     2394030     // 36.53 C
+
+static inline int32_t mpu6050_scale_q16(int16_t raw, int32_t mul, int shift)
+{
+    return ((int32_t)raw * mul + (1 << (shift - 1))) >> shift;
+}
+
+// Converte count amostras de uma vez, sem divisao nem ponto flutuante, nas faixas do
+// perfil em uso. Erro maximo: acelerometro exato, giroscopio 0.001 dps por faixa de
+// 250 dps, temperatura 0.001 C.
+void mpu6050_convert_q16(const mpu6050_data_t *raw_data, mpu6050_q16_data_t *out, size_t count)
+{
+    int accel_shift = 2 + mpu6050_config.accel_range;
+    int gyro_shift = MPU6050_GYRO_Q16_SHIFT - mpu6050_config.gyro_range;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const mpu6050_data_t *raw = &raw_data[i];
+        out[i].accel_g[0] = (int32_t)raw->accel_x * (1 << accel_shift);
+        out[i].accel_g[1] = (int32_t)raw->accel_y * (1 << accel_shift);
+        out[i].accel_g[2] = (int32_t)raw->accel_z * (1 << accel_shift);
+        out[i].gyro_dps[0] = mpu6050_scale_q16(raw->gyro_x, MPU6050_GYRO_Q16_MUL, gyro_shift);
+        out[i].gyro_dps[1] = mpu6050_scale_q16(raw->gyro_y, MPU6050_GYRO_Q16_MUL, gyro_shift);
+        out[i].gyro_dps[2] = mpu6050_scale_q16(raw->gyro_z, MPU6050_GYRO_Q16_MUL, gyro_shift);
+        out[i].temp_c = mpu6050_scale_q16(raw->temp, MPU6050_TEMP_Q16_MUL, MPU6050_TEMP_Q16_SHIFT) + MPU6050_TEMP_Q16_OFFSET;
+    }
+}
+
 void mpu6050_convert_data(mpu6050_data_t *raw_data, float *accel_g, float *gyro_dps, float *temp_c)
 {
-    accel_g[0] = (float)raw_data->accel_x / 16384.0f;
-    accel_g[1] = (float)raw_data->accel_y / 16384.0f;
-    accel_g[2] = (float)raw_data->accel_z / 16384.0f;
-    gyro_dps[0] = (float)raw_data->gyro_x / 131.0f;
-    gyro_dps[1] = (float)raw_data->gyro_y / 131.0f;
-    gyro_dps[2] = (float)raw_data->gyro_z / 131.0f;
-    *temp_c = (float)raw_data->temp / 340.0f + 36.53f;
+    mpu6050_q16_data_t q;
+    mpu6050_convert_q16(raw_data, &q, 1);
+
+    for (int i = 0; i < 3; i++)
+    {
+        accel_g[i] = MPU6050_Q16_TO_FLOAT(q.accel_g[i]);
+        gyro_dps[i] = MPU6050_Q16_TO_FLOAT(q.gyro_dps[i]);
+    }
+    *temp_c = MPU6050_Q16_TO_FLOAT(q.temp_c);
 }
 
+// atan(i / 64) em graus Q16
+static const int32_t mpu6050_atan_lut[(1 << MPU6050_ATAN_LUT_BITS) + 1] = {
+    0, 58666, 117304, 175884, 234379, 292760,
+    350999, 409070, 466945, 524598, 582003, 639135,
+    695970, 752484, 808654, 864460, 919879, 974893,
+    1029481, 1083627, 1137313, 1190524, 1243245, 1295461,
+    1347161, 1398332, 1448965, 1499049, 1548575, 1597536,
+    1645926, 1693738, 1740967, 1787610, 1833663, 1879123,
+    1923990, 1968261, 2011937, 2055018, 2097505, 2139399,
+    2180703, 2221419, 2261551, 2301101, 2340074, 2378474,
+    2416306, 2453574, 2490285, 2526443, 2562055, 2597126,
+    2631664, 2665673, 2699161, 2732134, 2764600, 2796564,
+    2828035, 2859019, 2889523, 2919554, 2949120,
+};
+
+// atan2 em graus Q16, de -180 a 180, por tabela interpolada no primeiro octante.
+// Erro maximo de 0.005 grau; x e y so precisam estar na mesma escala.
+int32_t mpu6050_atan2_deg_q16(int32_t y, int32_t x)
+{
+    if (x == 0 && y == 0)
+    {
+        return 0;
+    }
+
+    uint32_t ax = x < 0 ? -(uint32_t)x : (uint32_t)x;
+    uint32_t ay = y < 0 ? -(uint32_t)y : (uint32_t)y;
+    bool swap = ay > ax;
+    uint32_t num = swap ? ax : ay;
+    uint32_t den = swap ? ay : ax;
+
+    // Reduz para 15 bits para que num << 16 caiba em 32 bits
+    int bits = 32 - __builtin_clz(den);
+    if (bits > 15)
+    {
+        num >>= bits - 15;
+        den >>= bits - 15;
+    }
+
+    uint32_t t = (num << 16) / den;
+    uint32_t idx = t >> (16 - MPU6050_ATAN_LUT_BITS);
+    uint32_t frac = t & ((1 << (16 - MPU6050_ATAN_LUT_BITS)) - 1);
+    int32_t angle = mpu6050_atan_lut[idx];
+    if (idx < (1 << MPU6050_ATAN_LUT_BITS))
+    {
+        angle += ((mpu6050_atan_lut[idx + 1] - angle) * (int32_t)frac) >> (16 - MPU6050_ATAN_LUT_BITS);
+    }
+
+    if (swap)
+    {
+        angle = 90 * MPU6050_Q16_ONE - angle;
+    }
+    if (x < 0)
+    {
+        angle = 180 * MPU6050_Q16_ONE - angle;
+    }
+    return y < 0 ? -angle : angle;
+}
+
+static void IRAM_ATTR mpu6050_int_isr_handler(void *arg)
+{
+    mpu6050_int_timestamp_us = esp_timer_get_time();
+
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(mpu6050_sampling_task_handle, &xHigherPriorityTaskWoken);
+
+    if (xHigherPriorityTaskWoken)
+    {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static esp_err_t mpu6050_int_enable(int int_gpio)
+{
+    const gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << int_gpio,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_POSEDGE,
+    };
+    esp_err_t ret = gpio_config(&io_conf);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE)
+    {
+        return ret;
+    }
+
+    ret = gpio_isr_handler_add(int_gpio, mpu6050_int_isr_handler, NULL);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    ret = mpu6050_write_byte(MPU6050_INT_PIN_CFG, 0x00);
+    if (ret == ESP_OK)
+    {
+        ret = mpu6050_write_int_enable(true);
+    }
+    if (ret != ESP_OK)
+    {
+        gpio_isr_handler_remove(int_gpio);
+        return ret;
+    }
+
+    mpu6050_int_gpio = int_gpio;
+    mpu6050_int_active = true;
+    return ESP_OK;
+}
+
+static void mpu6050_int_disable(void)
+{
+    mpu6050_int_active = false;
+    gpio_isr_handler_remove(mpu6050_int_gpio);
+    mpu6050_write_int_enable(false);
+}
+
+// Le uma amostra a cada pulso de dado pronto. Sem o pino INT le em periodo fixo,
+// limitado ao tick do FreeRTOS.
 void mpu6050_task(void *pvParameters)
 {
     mpu6050_data_t sensor_data;
-    float accel_g[3], gyro_dps[3], temp_c;
+    TickType_t last_wake = xTaskGetTickCount();
+    uint32_t int_misses = 0;
+
+    while (!atomic_load(&mpu6050_sampling_stop))
+    {
+        int64_t timestamp_us;
+
+        if (mpu6050_int_active)
+        {
+            uint32_t pulses = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MPU6050_INT_TIMEOUT_MS));
+            if (pulses == 0)
+            {
+                // Uma recuperacao do barramento ja para os pulsos por mais de um prazo; le uma
+                // vez e continua no INT, e so desiste depois de varios prazos seguidos
+                if (++int_misses >= MPU6050_INT_MAX_MISSES)
+                {
+                    ESP_LOGW(TAG, "Sem interrupcao no GPIO %d, voltando para leitura periodica", mpu6050_int_gpio);
+                    mpu6050_int_disable();
+                    mpu6050_sampling_stats.interrupt_driven = false;
+                    last_wake = xTaskGetTickCount();
+                    continue;
+                }
+                timestamp_us = esp_timer_get_time();
+            }
+            else
+            {
+                int_misses = 0;
+                mpu6050_sampling_stats.overruns += pulses - 1;
+                timestamp_us = mpu6050_int_timestamp_us;
+            }
+        }
+        else
+        {
+            TickType_t period = pdMS_TO_TICKS(1000 / mpu6050_get_sample_rate_hz());
+            vTaskDelayUntil(&last_wake, period > 0 ? period : 1);
+            timestamp_us = esp_timer_get_time();
+        }
+
+        if (mpu6050_read_all(&sensor_data) != ESP_OK)
+        {
+            mpu6050_sampling_stats.errors++;
+            continue;
+        }
+        mpu6050_sampling_stats.samples++;
+        if (mpu6050_sample_cb)
+        {
+            mpu6050_sample_cb(&sensor_data, timestamp_us, mpu6050_sample_cb_arg);
+        }
+    }
+
+    // O ISR acorda esta tarefa, entao sai antes dela
+    if (mpu6050_int_active)
+    {
+        mpu6050_int_disable();
+    }
+    xSemaphoreGive(mpu6050_sampling_done);
+    vTaskDelete(NULL);
+}
+
+// Sobe a tarefa de amostragem; com int_gpio < 0, ou se o pino nao puder ser
+// configurado, fica na leitura periodica. rate_hz = 0 mantem a taxa do perfil.
+esp_err_t mpu6050_start_sampling(int int_gpio, uint32_t rate_hz, mpu6050_sample_cb_t cb, void *cb_arg)
+{
+    if (mpu6050_sampling_task_handle != NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = ESP_OK;
+    if (rate_hz != 0)
+    {
+        ret = mpu6050_set_sample_rate_hz(rate_hz);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+    }
+
+    mpu6050_sample_cb = cb;
+    mpu6050_sample_cb_arg = cb_arg;
+    memset(&mpu6050_sampling_stats, 0, sizeof(mpu6050_sampling_stats));
+    if (mpu6050_sampling_done == NULL)
+    {
+        mpu6050_sampling_done = xSemaphoreCreateBinaryStatic(&mpu6050_sampling_done_buffer);
+    }
+    atomic_store(&mpu6050_sampling_stop, false);
 
-    while (1)
+    if (xTaskCreatePinnedToCore(mpu6050_task, "mpu6050_sampling", MPU6050_SAMPLING_TASK_STACK, NULL,
+                                MPU6050_SAMPLING_TASK_PRIORITY, &mpu6050_sampling_task_handle, tskNO_AFFINITY) != pdPASS)
     {
-        esp_err_t ret = mpu6050_read_all(&sensor_data);
-        if (ret == ESP_OK)
+        mpu6050_sampling_task_handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (int_gpio >= 0)
+    {
+        ret = mpu6050_int_enable(int_gpio);
+        if (ret != ESP_OK)
         {
-            mpu6050_convert_data(&sensor_data, accel_g, gyro_dps, &temp_c);
+            ESP_LOGW(TAG, "Interrupcao no GPIO %d indisponivel (%s), usando leitura periodica", int_gpio, esp_err_to_name(ret));
         }
-        vTaskDelay(500 / portTICK_PERIOD_MS); 
     }
+    mpu6050_sampling_stats.interrupt_driven = mpu6050_int_active;
+
+    ESP_LOGI(TAG, "Amostragem a %lu Hz por %s", (unsigned long)mpu6050_get_sample_rate_hz(),
+             mpu6050_int_active ? "interrupcao" : "leitura periodica");
+    return ESP_OK;
+}
+
+// Espera a tarefa de amostragem sair; a leitura em andamento ainda chega ao callback
+esp_err_t mpu6050_stop_sampling(void)
+{
+    if (mpu6050_sampling_task_handle == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    atomic_store(&mpu6050_sampling_stop, true);
+    xSemaphoreTake(mpu6050_sampling_done, portMAX_DELAY);
+    mpu6050_sampling_task_handle = NULL;
+    return ESP_OK;
+}
+
+void mpu6050_get_sampling_stats(mpu6050_sampling_stats_t *out)
+{
+    *out = mpu6050_sampling_stats;
 }
 
 esp_err_t mpu6050_read_acceleration(float *ax, float *ay, float *az)
@@ -186,4 +556,290 @@ esp_err_t mpu6050_read_acceleration(float *ax, float *ay, float *az)
     *az = converted_accel[2];
 
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+static uint32_t mpu6050_base_rate_hz(void)
+{
+    return mpu6050_config.dlpf == MPU6050_DLPF_OFF ? MPU6050_GYRO_RATE_HZ : MPU6050_GYRO_RATE_DLPF_HZ;
+}
+
+uint32_t mpu6050_get_sample_rate_hz(void)
+{
+    return mpu6050_base_rate_hz() / (1 + mpu6050_smplrt_div);
+}
+
+static esp_err_t mpu6050_set_divider(uint32_t rate_hz)
+{
+    uint32_t base = mpu6050_base_rate_hz();
+    if (rate_hz == 0 || rate_hz > base)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t div = (base + rate_hz / 2) / rate_hz - 1;
+    mpu6050_smplrt_div = div > 255 ? 255 : div;
+    mpu6050_config.sample_rate_hz = mpu6050_get_sample_rate_hz();
+    return ESP_OK;
+}
+
+// Arredonda para o divisor mais proximo; de 8 kHz ate ~31 Hz com o DLPF desligado,
+// de 1 kHz ate ~4 Hz com ele ligado
+esp_err_t mpu6050_set_sample_rate_hz(uint32_t rate_hz)
+{
+    esp_err_t ret = mpu6050_set_divider(rate_hz);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    return mpu6050_write_byte(MPU6050_SMPLRT_DIV, mpu6050_smplrt_div);
+}
+
+// Grava na peca a taxa, o DLPF e as faixas de mpu6050_config
+static esp_err_t mpu6050_write_config(void)
+{
+    esp_err_t ret = mpu6050_write_byte(MPU6050_SMPLRT_DIV, mpu6050_smplrt_div);
+    if (ret == ESP_OK)
+    {
+        ret = mpu6050_write_byte(MPU6050_CONFIG, mpu6050_config.dlpf);
+    }
+    if (ret == ESP_OK)
+    {
+        ret = mpu6050_write_byte(MPU6050_GYRO_CONFIG, mpu6050_config.gyro_range << 3);
+    }
+    if (ret == ESP_OK)
+    {
+        ret = mpu6050_write_byte(MPU6050_ACCEL_CONFIG, mpu6050_config.accel_range << 3);
+    }
+    return ret;
+}
+
+// Troca taxa, DLPF e faixas de uma vez. A conversao le mpu6050_config sem trava, entao
+// com a amostragem rodando so a propria tarefa de amostragem pode chamar; os jogos pedem
+// a troca por sensor_set_profile. Se uma escrita falha, o perfil anterior volta para a
+// struct e e regravado na peca; o reinit depois de uma recuperacao tambem grava a struct.
+esp_err_t mpu6050_set_config(const mpu6050_config_t *config)
+{
+    mpu6050_config_t previous = mpu6050_config;
+    uint8_t previous_div = mpu6050_smplrt_div;
+    mpu6050_config = *config;
+    esp_err_t ret = mpu6050_set_divider(config->sample_rate_hz);
+    if (ret != ESP_OK)
+    {
+        mpu6050_config = previous;
+        mpu6050_smplrt_div = previous_div;
+        return ret;
+    }
+
+    ret = mpu6050_write_config();
+    if (ret != ESP_OK)
+    {
+        mpu6050_config = previous;
+        mpu6050_smplrt_div = previous_div;
+        mpu6050_write_config();
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Perfil %s: %lu Hz", mpu6050_config.name, (unsigned long)mpu6050_config.sample_rate_hz);
+    return ESP_OK;
+}
+
+// So troca as escalas da conversao, sem tocar na peca; usado ao reproduzir uma gravacao
+void mpu6050_set_scale(mpu6050_accel_range_t accel_range, mpu6050_gyro_range_t gyro_range)
+{
+    mpu6050_config.accel_range = accel_range;
+    mpu6050_config.gyro_range = gyro_range;
+}
+
+const mpu6050_config_t *mpu6050_get_config(void)
+{
+    return &mpu6050_config;
+}
+
+float mpu6050_accel_lsb_per_g(void)
+{
+    return 16384.0f / (1 << mpu6050_config.accel_range);
+}
+
+float mpu6050_gyro_lsb_per_dps(void)
+{
+    return 131.0f / (1 << mpu6050_config.gyro_range);
+}
+
+static uint8_t mpu6050_fifo_bytes_per_sample(uint8_t channels)
+{
+    uint8_t size = 0;
+    if (channels & MPU6050_FIFO_ACCEL)
+        size += 6;
+    if (channels & MPU6050_FIFO_TEMP)
+        size += 2;
+    if (channels & MPU6050_FIFO_GYRO_X)
+        size += 2;
+    if (channels & MPU6050_FIFO_GYRO_Y)
+        size += 2;
+    if (channels & MPU6050_FIFO_GYRO_Z)
+        size += 2;
+    return size;
+}
+
+// Tambem le INT_STATUS, para um transbordo de antes do reset nao ser contado de novo
+esp_err_t mpu6050_fifo_reset(void)
+{
+    esp_err_t ret = mpu6050_write_byte(MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_RESET);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    uint8_t status;
+    ret = mpu6050_read_byte(MPU6050_INT_STATUS, &status);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    return mpu6050_write_byte(MPU6050_USER_CTRL, mpu6050_fifo_channels ? MPU6050_USER_CTRL_FIFO_EN : 0x00);
+}
+
+esp_err_t mpu6050_fifo_enable(uint8_t channels)
+{
+    uint8_t sample_size = mpu6050_fifo_bytes_per_sample(channels);
+    if (sample_size == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    mpu6050_fifo_channels = channels;
+    mpu6050_fifo_sample_size = sample_size;
+
+    esp_err_t ret = mpu6050_write_byte(MPU6050_FIFO_EN, channels);
+    if (ret == ESP_OK)
+    {
+        ret = mpu6050_write_int_enable(mpu6050_int_active);
+    }
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    return mpu6050_fifo_reset();
+}
+
+esp_err_t mpu6050_fifo_disable(void)
+{
+    mpu6050_fifo_channels = 0;
+    mpu6050_fifo_sample_size = 0;
+
+    esp_err_t ret = mpu6050_write_byte(MPU6050_FIFO_EN, 0x00);
+    if (ret == ESP_OK)
+    {
+        ret = mpu6050_write_int_enable(mpu6050_int_active);
+    }
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    return mpu6050_write_byte(MPU6050_USER_CTRL, 0x00);
+}
+
+esp_err_t mpu6050_fifo_count(uint16_t *bytes)
+{
+    uint8_t count[2];
+    esp_err_t ret = mpu6050_read_bytes(MPU6050_FIFO_COUNTH, count, 2);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    *bytes = (uint16_t)((count[0] << 8) | count[1]);
+    return ESP_OK;
+}
+
+static int16_t mpu6050_fifo_word(const uint8_t **p)
+{
+    int16_t value = (int16_t)(((*p)[0] << 8) | (*p)[1]);
+    *p += 2;
+    return value;
+}
+
+// Converte uma amostra da FIFO; canais desligados ficam em zero
+static void mpu6050_fifo_parse(const uint8_t *p, mpu6050_data_t *data)
+{
+    memset(data, 0, sizeof(*data));
+    if (mpu6050_fifo_channels & MPU6050_FIFO_ACCEL)
+    {
+        data->accel_x = mpu6050_fifo_word(&p);
+        data->accel_y = mpu6050_fifo_word(&p);
+        data->accel_z = mpu6050_fifo_word(&p);
+    }
+    if (mpu6050_fifo_channels & MPU6050_FIFO_TEMP)
+        data->temp = mpu6050_fifo_word(&p);
+    if (mpu6050_fifo_channels & MPU6050_FIFO_GYRO_X)
+        data->gyro_x = mpu6050_fifo_word(&p);
+    if (mpu6050_fifo_channels & MPU6050_FIFO_GYRO_Y)
+        data->gyro_y = mpu6050_fifo_word(&p);
+    if (mpu6050_fifo_channels & MPU6050_FIFO_GYRO_Z)
+        data->gyro_z = mpu6050_fifo_word(&p);
+}
+
+// Esvazia ate max_samples amostras, da mais antiga para a mais nova, espacadas de
+// 1 / mpu6050_get_sample_rate_hz(). A peca grava a FIFO byte a byte, entao o contador
+// pode pegar uma amostra pela metade; ela fica para a proxima chamada. Se a FIFO
+// transbordou o alinhamento se perdeu: ela e zerada e a chamada retorna
+// ESP_ERR_INVALID_STATE sem amostras.
+esp_err_t mpu6050_fifo_read(mpu6050_data_t *samples, size_t max_samples, size_t *out_count)
+{
+    *out_count = 0;
+    if (mpu6050_fifo_sample_size == 0)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t status;
+    esp_err_t ret = mpu6050_read_byte(MPU6050_INT_STATUS, &status);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    if (status & MPU6050_INT_FIFO_OFLOW)
+    {
+        mpu6050_fifo_overflows++;
+        mpu6050_fifo_reset();
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint16_t bytes;
+    ret = mpu6050_fifo_count(&bytes);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    size_t available = bytes / mpu6050_fifo_sample_size;
+    if (available > max_samples)
+    {
+        available = max_samples;
+    }
+
+    while (*out_count < available)
+    {
+        size_t burst = available - *out_count;
+        if (burst > MPU6050_FIFO_BURST_SAMPLES)
+        {
+            burst = MPU6050_FIFO_BURST_SAMPLES;
+        }
+
+        // Leituras seguidas de FIFO_R_W devolvem os proximos bytes da fila
+        ret = mpu6050_read_bytes(MPU6050_FIFO_R_W, mpu6050_fifo_buffer, burst * mpu6050_fifo_sample_size);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+        for (size_t i = 0; i < burst; i++)
+        {
+            mpu6050_fifo_parse(&mpu6050_fifo_buffer[i * mpu6050_fifo_sample_size], &samples[*out_count + i]);
+        }
+        *out_count += burst;
+    }
+    return ESP_OK;
+}
+
+uint32_t mpu6050_get_fifo_overflows(void)
+{
+    return mpu6050_fifo_overflows;
+}
@@ -0,0 +1,213 @@
+#include "record.h"
+#include <string.h>
+
+static void record_put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void record_put_u32(uint8_t *p, uint32_t v)
+{
+    record_put_u16(p, v & 0xFFFF);
+    record_put_u16(p + 2, v >> 16);
+}
+
+static uint16_t record_get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t record_get_u32(const uint8_t *p)
+{
+    return record_get_u16(p) | ((uint32_t)record_get_u16(p + 2) << 16);
+}
+
+static void record_encode_header(uint8_t *buf, const record_info_t *info)
+{
+    memcpy(buf, RECORD_MAGIC, 4);
+    record_put_u16(buf + 4, RECORD_VERSION);
+    record_put_u16(buf + 6, RECORD_SIZE);
+    record_put_u32(buf + 8, info->sample_rate_hz);
+    buf[12] = info->dlpf;
+    buf[13] = info->accel_range;
+    buf[14] = info->gyro_range;
+    buf[15] = 0;
+}
+
+static esp_err_t record_decode_header(const uint8_t *buf, record_info_t *info)
+{
+    if (memcmp(buf, RECORD_MAGIC, 4) != 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (record_get_u16(buf + 4) != RECORD_VERSION || record_get_u16(buf + 6) != RECORD_SIZE)
+    {
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    info->sample_rate_hz = record_get_u32(buf + 8);
+    info->dlpf = buf[12];
+    info->accel_range = buf[13];
+    info->gyro_range = buf[14];
+    return ESP_OK;
+}
+
+// Cria o arquivo ou anexa uma nova sessao a um existente. Anexar exige as mesmas faixas
+// e a mesma taxa, ja que o replay converte e preenche intervalos com as do cabecalho.
+esp_err_t record_writer_open(record_writer_t *writer, const char *path, const record_info_t *info)
+{
+    uint8_t header[RECORD_HEADER_SIZE];
+    memset(writer, 0, sizeof(*writer));
+
+    FILE *file = fopen(path, "r+b");
+    if (file == NULL)
+    {
+        file = fopen(path, "w+b");
+        if (file == NULL)
+        {
+            return ESP_FAIL;
+        }
+        record_encode_header(header, info);
+        if (fwrite(header, 1, sizeof(header), file) != sizeof(header))
+        {
+            fclose(file);
+            return ESP_FAIL;
+        }
+    }
+    else
+    {
+        record_info_t existing;
+        esp_err_t ret = ESP_ERR_INVALID_SIZE;
+        if (fread(header, 1, sizeof(header), file) == sizeof(header))
+        {
+            ret = record_decode_header(header, &existing);
+        }
+        if (ret == ESP_OK && (existing.accel_range != info->accel_range || existing.gyro_range != info->gyro_range ||
+                              existing.sample_rate_hz != info->sample_rate_hz))
+        {
+            ret = ESP_ERR_INVALID_ARG;
+        }
+        if (ret != ESP_OK)
+        {
+            fclose(file);
+            return ret;
+        }
+
+        // Um registro cortado no fim, de uma gravacao interrompida, e sobrescrito
+        fseek(file, 0, SEEK_END);
+        long records = (ftell(file) - RECORD_HEADER_SIZE) / RECORD_SIZE;
+        fseek(file, RECORD_HEADER_SIZE + records * RECORD_SIZE, SEEK_SET);
+    }
+
+    setvbuf(file, NULL, _IOFBF, RECORD_BUFFER_SIZE);
+    writer->file = file;
+    writer->session_start = true;
+    return ESP_OK;
+}
+
+esp_err_t record_write(record_writer_t *writer, const mpu6050_data_t *data, int64_t timestamp_us)
+{
+    uint8_t buf[RECORD_SIZE];
+    uint32_t delta = 0;
+
+    if (!writer->session_start)
+    {
+        int64_t elapsed = timestamp_us - writer->last_us;
+        delta = elapsed <= 0 ? 1 : elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+    }
+    writer->session_start = false;
+    writer->last_us = timestamp_us;
+
+    record_put_u32(buf, delta);
+    record_put_u16(buf + 4, data->accel_x);
+    record_put_u16(buf + 6, data->accel_y);
+    record_put_u16(buf + 8, data->accel_z);
+    record_put_u16(buf + 10, data->temp);
+    record_put_u16(buf + 12, data->gyro_x);
+    record_put_u16(buf + 14, data->gyro_y);
+    record_put_u16(buf + 16, data->gyro_z);
+
+    if (fwrite(buf, 1, sizeof(buf), writer->file) != sizeof(buf))
+    {
+        return ESP_FAIL;
+    }
+    writer->count++;
+    return ESP_OK;
+}
+
+esp_err_t record_writer_close(record_writer_t *writer)
+{
+    if (writer->file == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int ret = fclose(writer->file);
+    writer->file = NULL;
+    return ret == 0 ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t record_reader_open(record_reader_t *reader, const char *path)
+{
+    uint8_t header[RECORD_HEADER_SIZE];
+    memset(reader, 0, sizeof(*reader));
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t ret = ESP_ERR_INVALID_SIZE;
+    if (fread(header, 1, sizeof(header), file) == sizeof(header))
+    {
+        ret = record_decode_header(header, &reader->info);
+    }
+    if (ret != ESP_OK)
+    {
+        fclose(file);
+        return ret;
+    }
+
+    setvbuf(file, NULL, _IOFBF, RECORD_BUFFER_SIZE);
+    reader->file = file;
+    return ESP_OK;
+}
+
+// ESP_ERR_NOT_FOUND no fim do arquivo; um registro incompleto no fim tambem conta como fim
+esp_err_t record_read(record_reader_t *reader, mpu6050_data_t *data, int64_t *timestamp_us, bool *session_start)
+{
+    uint8_t buf[RECORD_SIZE];
+    if (fread(buf, 1, sizeof(buf), reader->file) != sizeof(buf))
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint32_t delta = record_get_u32(buf);
+    reader->timestamp_us += delta;
+
+    data->accel_x = (int16_t)record_get_u16(buf + 4);
+    data->accel_y = (int16_t)record_get_u16(buf + 6);
+    data->accel_z = (int16_t)record_get_u16(buf + 8);
+    data->temp = (int16_t)record_get_u16(buf + 10);
+    data->gyro_x = (int16_t)record_get_u16(buf + 12);
+    data->gyro_y = (int16_t)record_get_u16(buf + 14);
+    data->gyro_z = (int16_t)record_get_u16(buf + 16);
+
+    *timestamp_us = reader->timestamp_us;
+    if (session_start)
+    {
+        *session_start = delta == 0;
+    }
+    return ESP_OK;
+}
+
+void record_reader_close(record_reader_t *reader)
+{
+    if (reader->file != NULL)
+    {
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+}
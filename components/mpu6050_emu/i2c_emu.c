@@ -0,0 +1,468 @@
+#include <stdlib.h>
+#include <string.h>
+#include "i2c_emu.h"
+#include "driver/i2c_master.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+
+// Cada byte leva 9 pulsos de SCL (8 bits e o ACK), mais o byte de endereco de cada START
+#define I2C_EMU_BITS_PER_BYTE       9
+#define I2C_EMU_PROBE_SPEED_HZ      100000
+
+struct i2c_master_bus_t
+{
+    i2c_master_bus_config_t config;
+    bool in_use;
+    bool configured;                // os pinos continuam valendo com o barramento desmontado
+    i2c_emu_stuck_t stuck;
+    uint32_t scl_pulses;            // pulsos manuais recebidos enquanto SDA esta preso
+};
+
+struct i2c_master_dev_t
+{
+    struct i2c_master_bus_t *bus;
+    uint16_t addr;
+    uint32_t speed_hz;
+};
+
+typedef struct
+{
+    bool in_use;
+    int port;
+    uint8_t addr;
+    const i2c_emu_device_ops_t *ops;
+    void *ctx;
+} i2c_emu_device_t;
+
+static struct i2c_master_bus_t i2c_emu_buses[I2C_EMU_MAX_PORTS];
+static i2c_emu_device_t i2c_emu_devices[I2C_EMU_MAX_DEVICES];
+static uint32_t i2c_emu_nacks_pending[128];
+static i2c_emu_stats_t i2c_emu_stats;
+
+static int64_t i2c_emu_virtual_us = 0;
+static bool i2c_emu_realtime = false;
+
+// Linhas e pinos comuns; sem ninguem puxando, os pull-ups deixam tudo em 1
+static uint8_t i2c_emu_gpio_level[I2C_EMU_GPIO_COUNT];
+static bool i2c_emu_gpio_ready = false;
+
+int64_t i2c_emu_now_us(void)
+{
+    return i2c_emu_realtime ? esp_timer_get_time() : i2c_emu_virtual_us;
+}
+
+void i2c_emu_advance_us(int64_t us)
+{
+    i2c_emu_virtual_us += us;
+}
+
+void i2c_emu_set_realtime(bool realtime)
+{
+    i2c_emu_realtime = realtime;
+}
+
+void i2c_emu_get_stats(i2c_emu_stats_t *out)
+{
+    *out = i2c_emu_stats;
+}
+
+void i2c_emu_reset_stats(void)
+{
+    memset(&i2c_emu_stats, 0, sizeof(i2c_emu_stats));
+}
+
+esp_err_t i2c_emu_attach(int port, uint8_t addr, const i2c_emu_device_ops_t *ops, void *ctx)
+{
+    if (port < 0 || port >= I2C_EMU_MAX_PORTS || addr >= 128)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    i2c_emu_device_t *free_slot = NULL;
+    for (int i = 0; i < I2C_EMU_MAX_DEVICES; i++)
+    {
+        i2c_emu_device_t *dev = &i2c_emu_devices[i];
+        if (dev->in_use && dev->port == port && dev->addr == addr)
+        {
+            free_slot = dev;
+            break;
+        }
+        if (!dev->in_use && free_slot == NULL)
+        {
+            free_slot = dev;
+        }
+    }
+    if (free_slot == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    *free_slot = (i2c_emu_device_t){
+        .in_use = true,
+        .port = port,
+        .addr = addr,
+        .ops = ops,
+        .ctx = ctx,
+    };
+    return ESP_OK;
+}
+
+void i2c_emu_detach(int port, uint8_t addr)
+{
+    for (int i = 0; i < I2C_EMU_MAX_DEVICES; i++)
+    {
+        if (i2c_emu_devices[i].in_use && i2c_emu_devices[i].port == port && i2c_emu_devices[i].addr == addr)
+        {
+            i2c_emu_devices[i].in_use = false;
+        }
+    }
+}
+
+void i2c_emu_inject_nack(uint8_t addr, uint32_t count)
+{
+    i2c_emu_nacks_pending[addr & 0x7F] = count;
+}
+
+// A falha fica na porta, e continua valendo quando o i2clib recria o barramento
+void i2c_emu_stick_bus(int port, i2c_emu_stuck_t stuck)
+{
+    if (port < 0 || port >= I2C_EMU_MAX_PORTS)
+    {
+        return;
+    }
+    i2c_emu_buses[port].stuck = stuck;
+    i2c_emu_buses[port].scl_pulses = 0;
+}
+
+static i2c_emu_device_t *i2c_emu_find(int port, uint16_t addr)
+{
+    for (int i = 0; i < I2C_EMU_MAX_DEVICES; i++)
+    {
+        if (i2c_emu_devices[i].in_use && i2c_emu_devices[i].port == port && i2c_emu_devices[i].addr == addr)
+        {
+            return &i2c_emu_devices[i];
+        }
+    }
+    return NULL;
+}
+
+// Comum a todas as transacoes: avanca o relogio, aplica as falhas e acha a peca.
+// Retorna ESP_OK com *out preenchido quando a peca confirmou o endereco.
+static esp_err_t i2c_emu_begin(struct i2c_master_bus_t *bus, uint16_t addr, uint32_t speed_hz, size_t bytes,
+                               int timeout_ms, i2c_emu_device_t **out)
+{
+    i2c_emu_stats.transactions++;
+
+    if (bus->stuck != I2C_EMU_STUCK_NONE)
+    {
+        i2c_emu_virtual_us += (int64_t)timeout_ms * 1000;
+        i2c_emu_stats.timeouts++;
+        return ESP_ERR_TIMEOUT;
+    }
+
+    i2c_emu_virtual_us += (int64_t)bytes * I2C_EMU_BITS_PER_BYTE * 1000000 / speed_hz;
+
+    i2c_emu_device_t *dev = i2c_emu_find(bus->config.i2c_port, addr);
+    if (dev == NULL || i2c_emu_nacks_pending[addr & 0x7F] > 0)
+    {
+        if (dev != NULL)
+        {
+            i2c_emu_nacks_pending[addr & 0x7F]--;
+        }
+        i2c_emu_stats.nacks++;
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    i2c_emu_stats.bytes += bytes;
+    *out = dev;
+    return ESP_OK;
+}
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *bus_config, i2c_master_bus_handle_t *ret_bus_handle)
+{
+    int port = bus_config->i2c_port;
+    if (port < 0 || port >= I2C_EMU_MAX_PORTS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct i2c_master_bus_t *bus = &i2c_emu_buses[port];
+    if (bus->in_use)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    bus->config = *bus_config;
+    bus->in_use = true;
+    bus->configured = true;
+    *ret_bus_handle = bus;
+    return ESP_OK;
+}
+
+esp_err_t i2c_del_master_bus(i2c_master_bus_handle_t bus_handle)
+{
+    bus_handle->in_use = false;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle, const i2c_device_config_t *dev_config,
+                                    i2c_master_dev_handle_t *ret_handle)
+{
+    struct i2c_master_dev_t *dev = calloc(1, sizeof(*dev));
+    if (dev == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    dev->bus = bus_handle;
+    dev->addr = dev_config->device_address;
+    dev->speed_hz = dev_config->scl_speed_hz;
+    *ret_handle = dev;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t handle)
+{
+    free(handle);
+    return ESP_OK;
+}
+
+// O reset do controlador gera pulsos em SCL, o que basta para o caso simples
+esp_err_t i2c_master_bus_reset(i2c_master_bus_handle_t bus_handle)
+{
+    if (bus_handle->stuck == I2C_EMU_STUCK_SDA)
+    {
+        i2c_emu_stick_bus(bus_handle->config.i2c_port, I2C_EMU_STUCK_NONE);
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_probe(i2c_master_bus_handle_t bus_handle, uint16_t address, int xfer_timeout_ms)
+{
+    if (bus_handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    i2c_emu_device_t *dev;
+    esp_err_t ret = i2c_emu_begin(bus_handle, address, I2C_EMU_PROBE_SPEED_HZ, 1, xfer_timeout_ms, &dev);
+    return ret == ESP_ERR_INVALID_RESPONSE ? ESP_ERR_NOT_FOUND : ret;
+}
+
+// Como no driver real, um handle nulo (o i2clib deixa assim quando a recriacao falha)
+// volta com erro em vez de derrubar o processo
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer, size_t write_size,
+                              int xfer_timeout_ms)
+{
+    if (i2c_dev == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    i2c_emu_device_t *dev;
+    esp_err_t ret = i2c_emu_begin(i2c_dev->bus, i2c_dev->addr, i2c_dev->speed_hz, 1 + write_size, xfer_timeout_ms, &dev);
+    if (ret != ESP_OK || dev->ops == NULL)
+    {
+        return ret;
+    }
+    return dev->ops->write(dev->ctx, write_buffer, write_size, true, i2c_emu_now_us());
+}
+
+esp_err_t i2c_master_multi_buffer_transmit(i2c_master_dev_handle_t i2c_dev,
+                                           i2c_master_transmit_multi_buffer_info_t *buffer_info_array,
+                                           size_t array_size, int xfer_timeout_ms)
+{
+    if (i2c_dev == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t total = 1;
+    for (size_t i = 0; i < array_size; i++)
+    {
+        total += buffer_info_array[i].buffer_size;
+    }
+
+    i2c_emu_device_t *dev;
+    esp_err_t ret = i2c_emu_begin(i2c_dev->bus, i2c_dev->addr, i2c_dev->speed_hz, total, xfer_timeout_ms, &dev);
+    if (ret != ESP_OK || dev->ops == NULL)
+    {
+        return ret;
+    }
+
+    int64_t now_us = i2c_emu_now_us();
+    for (size_t i = 0; i < array_size && ret == ESP_OK; i++)
+    {
+        ret = dev->ops->write(dev->ctx, buffer_info_array[i].write_buffer, buffer_info_array[i].buffer_size, i == 0, now_us);
+    }
+    return ret;
+}
+
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer, size_t write_size,
+                                      uint8_t *read_buffer, size_t read_size, int xfer_timeout_ms)
+{
+    if (i2c_dev == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    i2c_emu_device_t *dev;
+    esp_err_t ret = i2c_emu_begin(i2c_dev->bus, i2c_dev->addr, i2c_dev->speed_hz, 2 + write_size + read_size,
+                                  xfer_timeout_ms, &dev);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    if (dev->ops == NULL)
+    {
+        memset(read_buffer, 0xFF, read_size);
+        return ESP_OK;
+    }
+
+    int64_t now_us = i2c_emu_now_us();
+    ret = dev->ops->write(dev->ctx, write_buffer, write_size, true, now_us);
+    if (ret == ESP_OK)
+    {
+        ret = dev->ops->read(dev->ctx, read_buffer, read_size, now_us);
+    }
+    return ret;
+}
+
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t i2c_dev, uint8_t *read_buffer, size_t read_size,
+                             int xfer_timeout_ms)
+{
+    if (i2c_dev == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    i2c_emu_device_t *dev;
+    esp_err_t ret = i2c_emu_begin(i2c_dev->bus, i2c_dev->addr, i2c_dev->speed_hz, 1 + read_size, xfer_timeout_ms, &dev);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    if (dev->ops == NULL)
+    {
+        memset(read_buffer, 0xFF, read_size);
+        return ESP_OK;
+    }
+    return dev->ops->read(dev->ctx, read_buffer, read_size, i2c_emu_now_us());
+}
+
+// GPIOs: as linhas de um barramento travado leem 0; os demais pinos devolvem o ultimo
+// nivel escrito
+static void i2c_emu_gpio_init(void)
+{
+    if (!i2c_emu_gpio_ready)
+    {
+        memset(i2c_emu_gpio_level, 1, sizeof(i2c_emu_gpio_level));
+        i2c_emu_gpio_ready = true;
+    }
+}
+
+static struct i2c_master_bus_t *i2c_emu_bus_of_pin(gpio_num_t gpio_num, bool *is_sda)
+{
+    for (int p = 0; p < I2C_EMU_MAX_PORTS; p++)
+    {
+        struct i2c_master_bus_t *bus = &i2c_emu_buses[p];
+        if (bus->configured && (bus->config.sda_io_num == gpio_num || bus->config.scl_io_num == gpio_num))
+        {
+            *is_sda = bus->config.sda_io_num == gpio_num;
+            return bus;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    i2c_emu_gpio_init();
+    return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num)
+{
+    i2c_emu_gpio_init();
+    if (gpio_num >= 0 && gpio_num < I2C_EMU_GPIO_COUNT)
+    {
+        i2c_emu_gpio_level[gpio_num] = 1;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_pull_mode(gpio_num_t gpio_num, gpio_pull_mode_t pull)
+{
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (gpio_num < 0 || gpio_num >= I2C_EMU_GPIO_COUNT)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    i2c_emu_gpio_init();
+
+    // Cada subida de SCL com SDA preso conta como um pulso de recuperacao
+    bool is_sda;
+    struct i2c_master_bus_t *bus = i2c_emu_bus_of_pin(gpio_num, &is_sda);
+    if (bus != NULL && !is_sda && level && !i2c_emu_gpio_level[gpio_num] && bus->stuck == I2C_EMU_STUCK_SDA_HARD &&
+        ++bus->scl_pulses >= I2C_EMU_STUCK_PULSES)
+    {
+        i2c_emu_stick_bus(bus->config.i2c_port, I2C_EMU_STUCK_NONE);
+    }
+
+    i2c_emu_gpio_level[gpio_num] = level ? 1 : 0;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    if (gpio_num < 0 || gpio_num >= I2C_EMU_GPIO_COUNT)
+    {
+        return 0;
+    }
+    i2c_emu_gpio_init();
+
+    bool is_sda;
+    struct i2c_master_bus_t *bus = i2c_emu_bus_of_pin(gpio_num, &is_sda);
+    if (bus != NULL)
+    {
+        if ((is_sda && (bus->stuck == I2C_EMU_STUCK_SDA || bus->stuck == I2C_EMU_STUCK_SDA_HARD)) ||
+            (!is_sda && bus->stuck == I2C_EMU_STUCK_SCL))
+        {
+            return 0;
+        }
+    }
+    return i2c_emu_gpio_level[gpio_num];
+}
+
+// Nao ha interrupcoes no host; quem depende delas cai no modo sem interrupcao
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+{
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num)
+{
+    return ESP_OK;
+}
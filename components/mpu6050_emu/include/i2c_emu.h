@@ -0,0 +1,54 @@
+#ifndef I2C_EMU_H
+#define I2C_EMU_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// Barramento I2C emulado para builds em host Linux. Implementa a API i2c_master do IDF
+// e os GPIOs das linhas, entao o i2clib e os drivers rodam sem alteracao por cima dele.
+#define I2C_EMU_MAX_PORTS           2
+#define I2C_EMU_MAX_DEVICES         4
+#define I2C_EMU_GPIO_COUNT          49
+#define I2C_EMU_STUCK_PULSES        3       // pulsos em SCL ate o escravo soltar SDA no I2C_EMU_STUCK_SDA_HARD
+
+// Operacoes de uma peca emulada; now_us e o relogio do barramento no fim da transacao.
+// first indica o primeiro bloco de uma escrita, em que vem o endereco do registrador.
+typedef struct {
+    esp_err_t (*write)(void *ctx, const uint8_t *data, size_t len, bool first, int64_t now_us);
+    esp_err_t (*read)(void *ctx, uint8_t *data, size_t len, int64_t now_us);
+} i2c_emu_device_ops_t;
+
+typedef enum {
+    I2C_EMU_STUCK_NONE = 0,
+    I2C_EMU_STUCK_SDA,              // escravo segura SDA; o reset do controlador solta
+    I2C_EMU_STUCK_SDA_HARD,         // so solta com os pulsos manuais em SCL pelo GPIO
+    I2C_EMU_STUCK_SCL               // SCL em curto com o terra; nada solta ate limpar a falha
+} i2c_emu_stuck_t;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t nacks;
+    uint32_t timeouts;
+} i2c_emu_stats_t;
+
+// ops NULL registra uma peca que so confirma as escritas, como o display
+esp_err_t i2c_emu_attach(int port, uint8_t addr, const i2c_emu_device_ops_t *ops, void *ctx);
+void i2c_emu_detach(int port, uint8_t addr);
+
+// As proximas count transacoes com addr recebem NACK
+void i2c_emu_inject_nack(uint8_t addr, uint32_t count);
+void i2c_emu_stick_bus(int port, i2c_emu_stuck_t stuck);
+
+// Por padrao o relogio e virtual: cada transacao avanca o tempo que levaria no fio, e as
+// esperas por timeout nao bloqueiam. Com realtime as pecas seguem o esp_timer.
+int64_t i2c_emu_now_us(void);
+void i2c_emu_advance_us(int64_t us);
+void i2c_emu_set_realtime(bool realtime);
+
+void i2c_emu_get_stats(i2c_emu_stats_t *out);
+void i2c_emu_reset_stats(void);
+
+#endif
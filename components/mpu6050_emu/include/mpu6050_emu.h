@@ -0,0 +1,33 @@
+#ifndef MPU6050_EMU_H
+#define MPU6050_EMU_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "mpu6050_types.h"
+
+// Modelo do mapa de registradores do MPU6050 sobre o i2c_emu: WHO_AM_I, PWR_MGMT_1,
+// SMPLRT_DIV, CONFIG, escalas, leitura em rajada a partir de ACCEL_XOUT_H, FIFO e
+// INT_STATUS. As amostras saem na taxa programada, seguindo o relogio do barramento.
+// O pino INT nao e emulado; o driver cai na leitura periodica.
+#define MPU6050_EMU_MAX_CATCHUP     256     // amostras geradas de uma vez depois de um intervalo longo
+
+// Gera a amostra bruta do instante timestamp_us, nas escalas programadas
+typedef void (*mpu6050_emu_source_t)(int64_t timestamp_us, mpu6050_data_t *out, void *arg);
+
+typedef struct {
+    uint32_t samples;
+    uint32_t fifo_dropped;          // bytes descartados com a FIFO cheia
+    uint32_t reg_reads;             // bytes lidos
+    uint32_t reg_writes;            // bytes escritos, sem contar o endereco do registrador
+} mpu6050_emu_stats_t;
+
+// Chamar antes do mpu6050_init; port e o controlador onde a peca fica
+esp_err_t mpu6050_emu_attach(int port);
+void mpu6050_emu_reset(void);
+
+// source NULL volta para a peca parada, com 1 g em Z e 25 C
+void mpu6050_emu_set_source(mpu6050_emu_source_t source, void *arg);
+uint8_t mpu6050_emu_peek(uint8_t reg);
+void mpu6050_emu_get_stats(mpu6050_emu_stats_t *out);
+
+#endif
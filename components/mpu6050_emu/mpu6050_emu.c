@@ -0,0 +1,303 @@
+#include <string.h>
+#include "mpu6050_emu.h"
+#include "mpu6050_types.h"
+#include "i2c_emu.h"
+
+#define MPU6050_EMU_REG_COUNT       128
+#define MPU6050_EMU_ADDR            0x68    // AD0 em nivel baixo, o MPU6050_ADDR do i2clib
+#define MPU6050_EMU_WHO_AM_I_VALUE  0x68
+#define MPU6050_EMU_PWR_SLEEP       (1 << 6)
+#define MPU6050_EMU_PWR_RESET       (1 << 7)
+#define MPU6050_EMU_TEMP_25C        -3920   // (25 - 36.53) * 340
+
+typedef struct
+{
+    uint8_t regs[MPU6050_EMU_REG_COUNT];
+    uint8_t pointer;                // registrador da proxima leitura ou escrita
+    uint8_t fifo[MPU6050_FIFO_SIZE];
+    uint16_t fifo_head;             // proximo byte a sair
+    uint16_t fifo_count;
+    int64_t next_sample_us;
+    bool schedule_dirty;            // taxa mudou, reprograma a proxima amostra
+    mpu6050_emu_source_t source;
+    void *source_arg;
+    mpu6050_emu_stats_t stats;
+} mpu6050_emu_t;
+
+static mpu6050_emu_t mpu6050_emu;
+
+static void mpu6050_emu_rest_source(int64_t timestamp_us, mpu6050_data_t *out, void *arg)
+{
+    uint8_t afs_sel = (mpu6050_emu.regs[MPU6050_ACCEL_CONFIG] >> 3) & 0x03;
+
+    *out = (mpu6050_data_t){
+        .accel_z = (int16_t)(16384 >> afs_sel),
+        .temp = MPU6050_EMU_TEMP_25C,
+    };
+}
+
+void mpu6050_emu_reset(void)
+{
+    memset(mpu6050_emu.regs, 0, sizeof(mpu6050_emu.regs));
+    mpu6050_emu.regs[MPU6050_WHO_AM_I] = MPU6050_EMU_WHO_AM_I_VALUE;
+    mpu6050_emu.regs[MPU6050_PWR_MGMT_1] = MPU6050_EMU_PWR_SLEEP;
+    mpu6050_emu.pointer = 0;
+    mpu6050_emu.fifo_head = 0;
+    mpu6050_emu.fifo_count = 0;
+    mpu6050_emu.schedule_dirty = true;
+}
+
+static uint32_t mpu6050_emu_period_us(void)
+{
+    uint8_t dlpf = mpu6050_emu.regs[MPU6050_CONFIG] & 0x07;
+    uint32_t base_hz = (dlpf == 0 || dlpf == 7) ? MPU6050_GYRO_RATE_HZ : MPU6050_GYRO_RATE_DLPF_HZ;
+    return (uint32_t)((1 + mpu6050_emu.regs[MPU6050_SMPLRT_DIV]) * 1000000ULL / base_hz);
+}
+
+// Na peca real a FIFO cheia descarta os bytes mais antigos
+static void mpu6050_emu_fifo_push(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (mpu6050_emu.fifo_count == MPU6050_FIFO_SIZE)
+        {
+            mpu6050_emu.fifo_head = (mpu6050_emu.fifo_head + 1) % MPU6050_FIFO_SIZE;
+            mpu6050_emu.fifo_count--;
+            mpu6050_emu.stats.fifo_dropped++;
+            // Como na peca, o bit so aparece em INT_STATUS com a interrupcao ligada
+            if (mpu6050_emu.regs[MPU6050_INT_ENABLE] & MPU6050_INT_FIFO_OFLOW)
+            {
+                mpu6050_emu.regs[MPU6050_INT_STATUS] |= MPU6050_INT_FIFO_OFLOW;
+            }
+        }
+        mpu6050_emu.fifo[(mpu6050_emu.fifo_head + mpu6050_emu.fifo_count) % MPU6050_FIFO_SIZE] = data[i];
+        mpu6050_emu.fifo_count++;
+    }
+}
+
+static uint8_t mpu6050_emu_fifo_pop(void)
+{
+    if (mpu6050_emu.fifo_count == 0)
+    {
+        return 0xFF;
+    }
+    uint8_t value = mpu6050_emu.fifo[mpu6050_emu.fifo_head];
+    mpu6050_emu.fifo_head = (mpu6050_emu.fifo_head + 1) % MPU6050_FIFO_SIZE;
+    mpu6050_emu.fifo_count--;
+    return value;
+}
+
+static void mpu6050_emu_put_word(uint8_t *dst, int16_t value)
+{
+    dst[0] = (uint8_t)((uint16_t)value >> 8);
+    dst[1] = (uint8_t)value;
+}
+
+// Grava uma amostra nos registradores de saida e, se ligada, na FIFO na ordem dos registradores
+static void mpu6050_emu_sample(int64_t timestamp_us)
+{
+    mpu6050_data_t data;
+    if (mpu6050_emu.source != NULL)
+    {
+        mpu6050_emu.source(timestamp_us, &data, mpu6050_emu.source_arg);
+    }
+    else
+    {
+        mpu6050_emu_rest_source(timestamp_us, &data, NULL);
+    }
+
+    uint8_t *out = &mpu6050_emu.regs[MPU6050_ACCEL_XOUT_H];
+    mpu6050_emu_put_word(&out[0], data.accel_x);
+    mpu6050_emu_put_word(&out[2], data.accel_y);
+    mpu6050_emu_put_word(&out[4], data.accel_z);
+    mpu6050_emu_put_word(&out[6], data.temp);
+    mpu6050_emu_put_word(&out[8], data.gyro_x);
+    mpu6050_emu_put_word(&out[10], data.gyro_y);
+    mpu6050_emu_put_word(&out[12], data.gyro_z);
+
+    uint8_t channels = mpu6050_emu.regs[MPU6050_FIFO_EN];
+    if ((mpu6050_emu.regs[MPU6050_USER_CTRL] & MPU6050_USER_CTRL_FIFO_EN) && channels != 0)
+    {
+        uint8_t record[14];
+        size_t len = 0;
+        if (channels & MPU6050_FIFO_ACCEL)
+        {
+            memcpy(&record[len], &out[0], 6);
+            len += 6;
+        }
+        if (channels & MPU6050_FIFO_TEMP)
+        {
+            memcpy(&record[len], &out[6], 2);
+            len += 2;
+        }
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (channels & (MPU6050_FIFO_GYRO_X >> axis))
+            {
+                memcpy(&record[len], &out[8 + 2 * axis], 2);
+                len += 2;
+            }
+        }
+        mpu6050_emu_fifo_push(record, len);
+    }
+
+    mpu6050_emu.regs[MPU6050_INT_STATUS] |= MPU6050_INT_DATA_RDY;
+    mpu6050_emu.stats.samples++;
+}
+
+// Gera as amostras vencidas ate now_us; a peca dormindo nao amostra
+static void mpu6050_emu_advance(int64_t now_us)
+{
+    uint32_t period_us = mpu6050_emu_period_us();
+
+    if (mpu6050_emu.schedule_dirty || (mpu6050_emu.regs[MPU6050_PWR_MGMT_1] & MPU6050_EMU_PWR_SLEEP))
+    {
+        mpu6050_emu.next_sample_us = now_us + period_us;
+        mpu6050_emu.schedule_dirty = false;
+        return;
+    }
+
+    int64_t behind_us = now_us - mpu6050_emu.next_sample_us;
+    if (behind_us > (int64_t)period_us * MPU6050_EMU_MAX_CATCHUP)
+    {
+        mpu6050_emu.next_sample_us += (behind_us / period_us - MPU6050_EMU_MAX_CATCHUP) * period_us;
+    }
+
+    while (mpu6050_emu.next_sample_us <= now_us)
+    {
+        mpu6050_emu_sample(mpu6050_emu.next_sample_us);
+        mpu6050_emu.next_sample_us += period_us;
+    }
+}
+
+static void mpu6050_emu_write_reg(uint8_t reg, uint8_t value)
+{
+    switch (reg)
+    {
+    case MPU6050_PWR_MGMT_1:
+        if (value & MPU6050_EMU_PWR_RESET)
+        {
+            mpu6050_emu_reset();
+            return;
+        }
+        mpu6050_emu.schedule_dirty = true;
+        break;
+    case MPU6050_SMPLRT_DIV:
+    case MPU6050_CONFIG:
+        mpu6050_emu.schedule_dirty = true;
+        break;
+    case MPU6050_USER_CTRL:
+        if (value & MPU6050_USER_CTRL_FIFO_RESET)
+        {
+            mpu6050_emu.fifo_head = 0;
+            mpu6050_emu.fifo_count = 0;
+            value &= ~MPU6050_USER_CTRL_FIFO_RESET;
+        }
+        break;
+    case MPU6050_FIFO_R_W:
+        mpu6050_emu_fifo_push(&value, 1);
+        return;
+    case MPU6050_WHO_AM_I:
+    case MPU6050_INT_STATUS:
+    case MPU6050_FIFO_COUNTH:
+    case MPU6050_FIFO_COUNTH + 1:
+        return;
+    default:
+        if (reg >= MPU6050_ACCEL_XOUT_H && reg <= MPU6050_GYRO_ZOUT_L)
+        {
+            return;
+        }
+        break;
+    }
+    mpu6050_emu.regs[reg] = value;
+}
+
+static uint8_t mpu6050_emu_read_reg(uint8_t reg)
+{
+    switch (reg)
+    {
+    case MPU6050_FIFO_COUNTH:
+        return (uint8_t)(mpu6050_emu.fifo_count >> 8);
+    case MPU6050_FIFO_COUNTH + 1:
+        return (uint8_t)mpu6050_emu.fifo_count;
+    case MPU6050_FIFO_R_W:
+        return mpu6050_emu_fifo_pop();
+    case MPU6050_INT_STATUS:
+    {
+        // Ler INT_STATUS limpa os bits
+        uint8_t status = mpu6050_emu.regs[reg];
+        mpu6050_emu.regs[reg] = 0;
+        return status;
+    }
+    default:
+        return mpu6050_emu.regs[reg];
+    }
+}
+
+// O primeiro byte de cada escrita e o endereco do registrador; os seguintes avancam o
+// endereco, menos em FIFO_R_W
+static esp_err_t mpu6050_emu_write(void *ctx, const uint8_t *data, size_t len, bool first, int64_t now_us)
+{
+    mpu6050_emu_advance(now_us);
+
+    size_t i = 0;
+    if (first && len > 0)
+    {
+        mpu6050_emu.pointer = data[0] % MPU6050_EMU_REG_COUNT;
+        i = 1;
+    }
+    for (; i < len; i++)
+    {
+        mpu6050_emu_write_reg(mpu6050_emu.pointer, data[i]);
+        if (mpu6050_emu.pointer != MPU6050_FIFO_R_W)
+        {
+            mpu6050_emu.pointer = (mpu6050_emu.pointer + 1) % MPU6050_EMU_REG_COUNT;
+        }
+        mpu6050_emu.stats.reg_writes++;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t mpu6050_emu_read(void *ctx, uint8_t *data, size_t len, int64_t now_us)
+{
+    mpu6050_emu_advance(now_us);
+
+    for (size_t i = 0; i < len; i++)
+    {
+        data[i] = mpu6050_emu_read_reg(mpu6050_emu.pointer);
+        if (mpu6050_emu.pointer != MPU6050_FIFO_R_W)
+        {
+            mpu6050_emu.pointer = (mpu6050_emu.pointer + 1) % MPU6050_EMU_REG_COUNT;
+        }
+    }
+    mpu6050_emu.stats.reg_reads += len;
+    return ESP_OK;
+}
+
+static const i2c_emu_device_ops_t mpu6050_emu_ops = {
+    .write = mpu6050_emu_write,
+    .read = mpu6050_emu_read,
+};
+
+esp_err_t mpu6050_emu_attach(int port)
+{
+    mpu6050_emu_reset();
+    memset(&mpu6050_emu.stats, 0, sizeof(mpu6050_emu.stats));
+    return i2c_emu_attach(port, MPU6050_EMU_ADDR, &mpu6050_emu_ops, NULL);
+}
+
+void mpu6050_emu_set_source(mpu6050_emu_source_t source, void *arg)
+{
+    mpu6050_emu.source = source;
+    mpu6050_emu.source_arg = arg;
+}
+
+uint8_t mpu6050_emu_peek(uint8_t reg)
+{
+    return mpu6050_emu.regs[reg % MPU6050_EMU_REG_COUNT];
+}
+
+void mpu6050_emu_get_stats(mpu6050_emu_stats_t *out)
+{
+    *out = mpu6050_emu.stats;
+}
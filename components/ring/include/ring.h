@@ -0,0 +1,43 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+
+// Fila sem lock para um produtor e um consumidor. O produtor pode ser um ISR; o
+// consumidor so e acordado quando a fila passa de vazia para nao vazia.
+#define RING_NOTIFY_INDEX           2   // indice de notificacao usado para acordar o consumidor
+
+typedef struct {
+    uint32_t pushed;
+    uint32_t dropped;               // itens perdidos com a fila cheia
+    uint32_t high_water;            // maior ocupacao vista
+} ring_stats_t;
+
+// head e tail contam itens sem voltar a zero; a posicao e o contador & mask
+typedef struct {
+    uint8_t *buffer;
+    size_t item_size;
+    uint32_t mask;                  // capacidade - 1
+    atomic_uint head;               // so o produtor escreve
+    atomic_uint tail;               // so o consumidor escreve
+    _Atomic(TaskHandle_t) consumer;
+    ring_stats_t stats;             // so o produtor escreve
+} ring_t;
+
+// buffer precisa ter capacity * item_size bytes; capacity potencia de dois
+esp_err_t ring_init(ring_t *ring, void *buffer, size_t item_size, uint32_t capacity);
+bool ring_push(ring_t *ring, const void *item);
+bool ring_push_from_isr(ring_t *ring, const void *item, BaseType_t *higher_priority_task_woken);
+bool ring_pop(ring_t *ring, void *item);
+bool ring_wait(ring_t *ring, void *item, TickType_t ticks_to_wait);
+void ring_reset(ring_t *ring);
+uint32_t ring_count(const ring_t *ring);
+void ring_get_stats(const ring_t *ring, ring_stats_t *out);
+
+#endif
@@ -0,0 +1,123 @@
+#include <string.h>
+#include "ring.h"
+#include "esp_attr.h"
+
+esp_err_t ring_init(ring_t *ring, void *buffer, size_t item_size, uint32_t capacity)
+{
+    if (ring == NULL || buffer == NULL || item_size == 0 || capacity == 0 || (capacity & (capacity - 1)) != 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ring->buffer = buffer;
+    ring->item_size = item_size;
+    ring->mask = capacity - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->consumer, NULL);
+    memset(&ring->stats, 0, sizeof(ring->stats));
+    return ESP_OK;
+}
+
+// Grava o item e devolve o consumidor a acordar, ou NULL. head e publicado e tail
+// relido em ordem sequencial; ring_pop faz o inverso, entao se o consumidor viu a fila
+// vazia antes deste item, o produtor ve tail igual ao head antigo e acorda o consumidor.
+static inline TaskHandle_t IRAM_ATTR ring_write(ring_t *ring, const void *item, bool *written)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail > ring->mask)
+    {
+        ring->stats.dropped++;
+        *written = false;
+        return NULL;
+    }
+
+    memcpy(ring->buffer + (head & ring->mask) * ring->item_size, item, ring->item_size);
+    atomic_store(&ring->head, head + 1);
+    *written = true;
+
+    tail = atomic_load(&ring->tail);
+    uint32_t used = head + 1 - tail;
+    ring->stats.pushed++;
+    if (used > ring->stats.high_water)
+    {
+        ring->stats.high_water = used;
+    }
+    return tail == head ? atomic_load(&ring->consumer) : NULL;
+}
+
+bool ring_push(ring_t *ring, const void *item)
+{
+    bool written;
+    TaskHandle_t consumer = ring_write(ring, item, &written);
+    if (consumer != NULL)
+    {
+        xTaskNotifyGiveIndexed(consumer, RING_NOTIFY_INDEX);
+    }
+    return written;
+}
+
+bool IRAM_ATTR ring_push_from_isr(ring_t *ring, const void *item, BaseType_t *higher_priority_task_woken)
+{
+    bool written;
+    TaskHandle_t consumer = ring_write(ring, item, &written);
+    if (consumer != NULL)
+    {
+        vTaskNotifyGiveIndexedFromISR(consumer, RING_NOTIFY_INDEX, higher_priority_task_woken);
+    }
+    return written;
+}
+
+bool ring_pop(ring_t *ring, void *item)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load(&ring->head);
+    if (head == tail)
+    {
+        return false;
+    }
+
+    memcpy(item, ring->buffer + (tail & ring->mask) * ring->item_size, ring->item_size);
+    atomic_store(&ring->tail, tail + 1);
+    return true;
+}
+
+// A tarefa que chama vira o consumidor. Notificacoes antigas so causam uma volta a mais.
+bool ring_wait(ring_t *ring, void *item, TickType_t ticks_to_wait)
+{
+    atomic_store(&ring->consumer, xTaskGetCurrentTaskHandle());
+
+    TickType_t start = xTaskGetTickCount();
+    while (!ring_pop(ring, item))
+    {
+        TickType_t timeout = portMAX_DELAY;
+        if (ticks_to_wait != portMAX_DELAY)
+        {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if (elapsed >= ticks_to_wait)
+            {
+                return false;
+            }
+            timeout = ticks_to_wait - elapsed;
+        }
+        ulTaskNotifyTakeIndexed(RING_NOTIFY_INDEX, pdTRUE, timeout);
+    }
+    return true;
+}
+
+// Descarta tudo o que esta na fila; chamar so do lado do consumidor
+void ring_reset(ring_t *ring)
+{
+    atomic_store(&ring->tail, atomic_load(&ring->head));
+}
+
+uint32_t ring_count(const ring_t *ring)
+{
+    return atomic_load(&ring->head) - atomic_load(&ring->tail);
+}
+
+void ring_get_stats(const ring_t *ring, ring_stats_t *out)
+{
+    *out = ring->stats;
+}
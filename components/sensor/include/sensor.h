@@ -0,0 +1,58 @@
+#ifndef SENSOR_H
+#define SENSOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "mpu6050.h"
+#include "fusion.h"
+#include "bias.h"
+#include "record.h"
+#include "ring.h"
+
+#define SENSOR_DEFAULT_PROFILE      MPU6050_PROFILE_BALANCED    // 250 Hz, ~9% do barramento a 400 kHz
+#define SENSOR_SLOTS                3
+#define SENSOR_FUSION_ALGORITHM     FUSION_COMPLEMENTARY
+#define SENSOR_REPLAY_TASK_STACK    4096
+#define SENSOR_RECORD_RING_SIZE     256     // amostras em espera pela escrita, ~0.25 s a 1 kHz
+#define SENSOR_RECORD_TASK_STACK    4096
+#define SENSOR_RECORD_TASK_PRIORITY 2       // abaixo dos jogos: a flash lenta nao atrasa ninguem
+#define SENSOR_PROFILE_TIMEOUT_MS   200     // espera da troca de perfil pela tarefa de amostragem
+#define SENSOR_PROFILE_DISCARD      1       // amostras descartadas depois da troca, ainda na escala antiga
+
+#define SENSOR_NVS_NAMESPACE        "sensor"
+#define SENSOR_CALIBRATION_VERSION  1       // mudar quando o formato de sensor_calibration_t mudar
+#define SENSOR_CALIBRATION_SAMPLES  30      // uma amostra por tick, ~0.3 s; o estimador de vies refina depois
+#define SENSOR_CALIBRATION_MAX_DRIFT_C  10.0f   // acima disso a calibracao salva deixa de valer
+
+typedef struct {
+    mpu6050_data_t raw;
+    mpu6050_q16_data_t fixed;
+    float accel_g[3];
+    float gyro_dps[3];              // ja sem o vies estimado; fixed fica sem correcao
+    float temp_c;
+    bias_estimate_t bias;           // vies corrente; accel_offset_g e a posicao de repouso
+    fusion_state_t orientation;     // estimativa ja com esta amostra
+    int64_t timestamp_us;           // instante do dado pronto na peca
+    uint32_t seq;                   // numero da amostra desde sensor_service_start
+} sensor_sample_t;
+
+typedef struct {
+    uint32_t version;
+    float accel_offset_g[3];        // leitura parada na posicao de jogo
+    float gyro_bias_dps[3];
+    float temp_c;                   // temperatura da peca durante a calibracao
+} sensor_calibration_t;
+
+esp_err_t sensor_service_start(void);
+esp_err_t sensor_service_stop(void);
+esp_err_t sensor_service_start_replay(const char *path, bool realtime);
+esp_err_t sensor_set_profile(const mpu6050_config_t *config);
+esp_err_t sensor_record_start(const char *path);
+esp_err_t sensor_record_stop(void);
+bool sensor_get_latest(sensor_sample_t *out);
+uint32_t sensor_get_sample_count(void);
+esp_err_t sensor_get_calibration(sensor_calibration_t *out);
+esp_err_t sensor_calibrate(sensor_calibration_t *out);
+
+#endif
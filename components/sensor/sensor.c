@@ -0,0 +1,544 @@
+#include "sensor.h"
+#include <math.h>
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "nvs.h"
+
+static const char *TAG = "SENSOR";
+
+// Buffer triplo: a tarefa de amostragem escreve sempre no slot seguinte ao publicado,
+// entao quem le so disputa um slot com ela depois de perder duas amostras inteiras.
+// O seq de cada slot fica impar durante a escrita; o leitor copia e confere se mudou.
+typedef struct {
+    atomic_uint seq;
+    sensor_sample_t sample;
+} sensor_slot_t;
+
+static sensor_slot_t sensor_slots[SENSOR_SLOTS];
+static atomic_uint sensor_published = 0;
+
+// Ultima calibracao completa. Ela so semeia o estimador de vies, que roda na tarefa de
+// amostragem; quem calibra pede a troca por sensor_bias_reseed.
+static sensor_calibration_t sensor_calibration;
+static bool sensor_calibration_loaded = false;
+static atomic_bool sensor_bias_reseed = false;
+static int64_t sensor_last_us = 0;
+
+// Gravacao: a publicacao so copia a amostra para o anel, e uma tarefa de prioridade
+// baixa escreve no arquivo. Com o anel cheio a amostra e perdida e contada.
+typedef struct {
+    mpu6050_data_t data;
+    int64_t timestamp_us;
+} sensor_record_item_t;
+
+static record_writer_t sensor_recorder;
+static ring_t sensor_record_ring;
+static sensor_record_item_t sensor_record_items[SENSOR_RECORD_RING_SIZE];
+static atomic_bool sensor_recording = false;
+static atomic_bool sensor_record_stopping = false;
+static TaskHandle_t sensor_record_task_handle = NULL;
+static SemaphoreHandle_t sensor_record_done = NULL;
+static StaticSemaphore_t sensor_record_done_buffer;
+// Depois da primeira falha de escrita a tarefa so esvazia o anel e conta o que perdeu
+static esp_err_t sensor_record_error = ESP_OK;
+static uint32_t sensor_record_failed = 0;
+
+// No replay o cabecalho da gravacao manda nas escalas e na taxa, e a peca fica parada
+static record_reader_t sensor_replay;
+static bool sensor_replay_realtime = true;
+static bool sensor_replaying = false;
+
+// Troca de perfil: so a tarefa de amostragem le mpu6050_config a cada amostra, entao ela
+// mesma aplica o perfil pedido, entre uma amostra e a seguinte
+static _Atomic(const mpu6050_config_t *) sensor_profile_request = NULL;
+static esp_err_t sensor_profile_result;
+static SemaphoreHandle_t sensor_profile_done = NULL;
+static StaticSemaphore_t sensor_profile_done_buffer;
+static uint32_t sensor_discard = 0;
+static bool sensor_sampling = false;
+
+// Roda na tarefa de amostragem, depois de publicar
+static void sensor_apply_profile(void)
+{
+    const mpu6050_config_t *config = atomic_exchange_explicit(&sensor_profile_request, NULL, memory_order_acquire);
+    if (config == NULL)
+    {
+        return;
+    }
+
+    sensor_profile_result = mpu6050_set_config(config);
+    fusion_init(SENSOR_FUSION_ALGORITHM);
+    atomic_store_explicit(&sensor_bias_reseed, true, memory_order_relaxed);
+    sensor_last_us = 0;
+    sensor_discard = SENSOR_PROFILE_DISCARD;
+    xSemaphoreGive(sensor_profile_done);
+}
+
+// Roda na tarefa de amostragem do mpu6050, unico escritor
+static void sensor_publish(const mpu6050_data_t *data, int64_t timestamp_us, void *arg)
+{
+    if (sensor_discard > 0)
+    {
+        sensor_discard--;
+        return;
+    }
+
+    unsigned count = atomic_load_explicit(&sensor_published, memory_order_relaxed);
+    sensor_slot_t *slot = &sensor_slots[count % SENSOR_SLOTS];
+
+    unsigned seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    if (atomic_exchange_explicit(&sensor_bias_reseed, false, memory_order_acquire))
+    {
+        bias_init(sensor_calibration.gyro_bias_dps, sensor_calibration.accel_offset_g,
+                  sensor_calibration_loaded ? 1.0f : 0.0f);
+    }
+
+    float dt = (timestamp_us - sensor_last_us) * 1e-6f;
+    if (sensor_last_us == 0 || dt <= 0.0f || dt > 0.1f)
+    {
+        dt = 1.0f / (sensor_replaying ? sensor_replay.info.sample_rate_hz : mpu6050_get_sample_rate_hz());
+    }
+    sensor_last_us = timestamp_us;
+
+    slot->sample.raw = *data;
+    mpu6050_convert_q16(data, &slot->sample.fixed, 1);
+    float gyro_raw[3];
+    for (int i = 0; i < 3; i++)
+    {
+        slot->sample.accel_g[i] = MPU6050_Q16_TO_FLOAT(slot->sample.fixed.accel_g[i]);
+        gyro_raw[i] = MPU6050_Q16_TO_FLOAT(slot->sample.fixed.gyro_dps[i]);
+    }
+    slot->sample.temp_c = MPU6050_Q16_TO_FLOAT(slot->sample.fixed.temp_c);
+
+    bias_update(slot->sample.accel_g, gyro_raw, dt, &slot->sample.bias);
+    for (int i = 0; i < 3; i++)
+    {
+        slot->sample.gyro_dps[i] = gyro_raw[i] - slot->sample.bias.gyro_bias_dps[i];
+    }
+    fusion_update(slot->sample.accel_g, slot->sample.gyro_dps, timestamp_us, &slot->sample.orientation);
+    slot->sample.timestamp_us = timestamp_us;
+    slot->sample.seq = count;
+
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+    atomic_store_explicit(&sensor_published, count + 1, memory_order_release);
+
+    if (atomic_load_explicit(&sensor_recording, memory_order_acquire))
+    {
+        const sensor_record_item_t item = {.data = *data, .timestamp_us = timestamp_us};
+        ring_push(&sensor_record_ring, &item);
+    }
+
+    sensor_apply_profile();
+}
+
+static esp_err_t sensor_calibration_load(void)
+{
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(SENSOR_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    sensor_calibration_t cal;
+    size_t len = sizeof(cal);
+    ret = nvs_get_blob(nvs, "calibration", &cal, &len);
+    nvs_close(nvs);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    if (len != sizeof(cal) || cal.version != SENSOR_CALIBRATION_VERSION)
+    {
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    sensor_calibration = cal;
+    sensor_calibration_loaded = true;
+    return ESP_OK;
+}
+
+static esp_err_t sensor_calibration_save(const sensor_calibration_t *cal)
+{
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(SENSOR_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    ret = nvs_set_blob(nvs, "calibration", cal, sizeof(*cal));
+    if (ret == ESP_OK)
+    {
+        ret = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return ret;
+}
+
+static void sensor_service_prepare(void)
+{
+    esp_err_t ret = sensor_calibration_load();
+    if (ret == ESP_OK)
+    {
+        ESP_LOGI(TAG, "Calibracao carregada (%.1f C)", sensor_calibration.temp_c);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Sem calibracao salva: %s", esp_err_to_name(ret));
+    }
+    atomic_store_explicit(&sensor_bias_reseed, true, memory_order_release);
+    fusion_init(SENSOR_FUSION_ALGORITHM);
+    if (sensor_profile_done == NULL)
+    {
+        sensor_profile_done = xSemaphoreCreateBinaryStatic(&sensor_profile_done_buffer);
+    }
+}
+
+// Precisa do nvs_flash_init feito antes; sem calibracao salva o servico roda sem correcao
+esp_err_t sensor_service_start(void)
+{
+    sensor_service_prepare();
+    esp_err_t ret = mpu6050_set_config(&SENSOR_DEFAULT_PROFILE);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    ret = mpu6050_start_sampling(MPU6050_INT_GPIO, 0, sensor_publish, NULL);
+    sensor_sampling = ret == ESP_OK;
+    return ret;
+}
+
+// Para a amostragem da peca, por exemplo antes de trocar para o replay
+esp_err_t sensor_service_stop(void)
+{
+    if (!sensor_sampling || atomic_load(&sensor_recording))
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t ret = mpu6050_stop_sampling();
+    if (ret == ESP_OK)
+    {
+        sensor_sampling = false;
+    }
+    return ret;
+}
+
+// Publica as amostras gravadas no lugar do sensor, no ritmo original ou o mais rapido
+// possivel. Os jogos nao percebem a diferenca.
+static void sensor_replay_task(void *pvParameters)
+{
+    mpu6050_data_t data;
+    int64_t timestamp_us;
+    int64_t start_us = esp_timer_get_time();
+    TickType_t start_tick = xTaskGetTickCount();
+    uint32_t samples = 0;
+
+    while (record_read(&sensor_replay, &data, &timestamp_us, NULL) == ESP_OK)
+    {
+        if (sensor_replay_realtime)
+        {
+            TickType_t due = start_tick + pdMS_TO_TICKS(timestamp_us / 1000);
+            TickType_t now = xTaskGetTickCount();
+            if ((int32_t)(due - now) > 0)
+            {
+                vTaskDelay(due - now);
+            }
+        }
+        sensor_publish(&data, start_us + timestamp_us, NULL);
+        samples++;
+    }
+
+    record_reader_close(&sensor_replay);
+    ESP_LOGI(TAG, "Replay terminado: %lu amostras", (unsigned long)samples);
+    vTaskDelete(NULL);
+}
+
+// Pede o perfil a tarefa de amostragem e espera ela aplicar. Vies e fusao recomecam na
+// taxa nova, e a amostra seguinte a troca, ainda na escala antiga, e descartada.
+esp_err_t sensor_set_profile(const mpu6050_config_t *config)
+{
+    if (config == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (sensor_replaying)
+    {
+        ESP_LOGI(TAG, "Replay: perfil %s ignorado, valem as escalas da gravacao", config->name);
+        return ESP_ERR_INVALID_STATE;
+    }
+    // O cabecalho da gravacao em andamento descreve as faixas de agora
+    if (!sensor_sampling || atomic_load(&sensor_recording))
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    atomic_store_explicit(&sensor_profile_request, config, memory_order_release);
+    if (xSemaphoreTake(sensor_profile_done, pdMS_TO_TICKS(SENSOR_PROFILE_TIMEOUT_MS)) != pdTRUE)
+    {
+        // Se a tarefa ja pegou o pedido, a troca esta em andamento e falta pouco
+        const mpu6050_config_t *expected = config;
+        if (atomic_compare_exchange_strong(&sensor_profile_request, &expected, NULL))
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+        xSemaphoreTake(sensor_profile_done, portMAX_DELAY);
+    }
+    return sensor_profile_result;
+}
+
+// Alternativa a sensor_service_start que le de um arquivo gravado por sensor_record_start.
+// A publicacao tem um escritor so, entao a amostragem da peca precisa estar parada.
+esp_err_t sensor_service_start_replay(const char *path, bool realtime)
+{
+    if (sensor_sampling)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = record_reader_open(&sensor_replay, path);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    sensor_service_prepare();
+    mpu6050_set_scale(sensor_replay.info.accel_range, sensor_replay.info.gyro_range);
+    sensor_replay_realtime = realtime;
+    sensor_replaying = true;
+
+    if (xTaskCreatePinnedToCore(sensor_replay_task, "sensor_replay", SENSOR_REPLAY_TASK_STACK, NULL,
+                                MPU6050_SAMPLING_TASK_PRIORITY, NULL, tskNO_AFFINITY) != pdPASS)
+    {
+        record_reader_close(&sensor_replay);
+        sensor_replaying = false;
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Replay de %s a %lu Hz", path, (unsigned long)sensor_replay.info.sample_rate_hz);
+    return ESP_OK;
+}
+
+// Esvazia o anel no arquivo ate sensor_record_stop pedir e o anel acabar
+static void sensor_record_task(void *pvParameters)
+{
+    sensor_record_item_t item;
+
+    while (1)
+    {
+        if (ring_wait(&sensor_record_ring, &item, pdMS_TO_TICKS(100)))
+        {
+            if (sensor_record_error == ESP_OK)
+            {
+                sensor_record_error = record_write(&sensor_recorder, &item.data, item.timestamp_us);
+                if (sensor_record_error != ESP_OK)
+                {
+                    ESP_LOGE(TAG, "Falha ao gravar, parando a escrita: %s", esp_err_to_name(sensor_record_error));
+                }
+            }
+            if (sensor_record_error != ESP_OK)
+            {
+                sensor_record_failed++;
+            }
+        }
+        else if (atomic_load(&sensor_record_stopping))
+        {
+            break;
+        }
+    }
+
+    xSemaphoreGive(sensor_record_done);
+    vTaskDelete(NULL);
+}
+
+// Grava as amostras brutas publicadas, anexando a um arquivo existente do mesmo perfil
+// (ESP_ERR_INVALID_ARG se as faixas ou a taxa forem outras). O perfil fica travado
+// enquanto grava, ja que o cabecalho guarda as faixas e a taxa.
+esp_err_t sensor_record_start(const char *path)
+{
+    if (sensor_record_task_handle != NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (sensor_record_done == NULL)
+    {
+        sensor_record_done = xSemaphoreCreateBinaryStatic(&sensor_record_done_buffer);
+    }
+
+    record_info_t info = sensor_replay.info;
+    if (!sensor_replaying)
+    {
+        const mpu6050_config_t *config = mpu6050_get_config();
+        info = (record_info_t){
+            .sample_rate_hz = config->sample_rate_hz,
+            .dlpf = config->dlpf,
+            .accel_range = config->accel_range,
+            .gyro_range = config->gyro_range,
+        };
+    }
+
+    esp_err_t ret = record_writer_open(&sensor_recorder, path, &info);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    ring_init(&sensor_record_ring, sensor_record_items, sizeof(sensor_record_items[0]), SENSOR_RECORD_RING_SIZE);
+    atomic_store(&sensor_record_stopping, false);
+    sensor_record_error = ESP_OK;
+    sensor_record_failed = 0;
+    if (xTaskCreatePinnedToCore(sensor_record_task, "sensor_record", SENSOR_RECORD_TASK_STACK, NULL,
+                                SENSOR_RECORD_TASK_PRIORITY, &sensor_record_task_handle, tskNO_AFFINITY) != pdPASS)
+    {
+        sensor_record_task_handle = NULL;
+        record_writer_close(&sensor_recorder);
+        return ESP_ERR_NO_MEM;
+    }
+    atomic_store_explicit(&sensor_recording, true, memory_order_release);
+    return ESP_OK;
+}
+
+// Para de copiar amostras, espera a tarefa gravar o que sobrou no anel e fecha o arquivo.
+// Retorna o erro da primeira escrita que falhou; o arquivo fica com o que veio antes dela.
+esp_err_t sensor_record_stop(void)
+{
+    if (sensor_record_task_handle == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    atomic_store(&sensor_recording, false);
+    atomic_store(&sensor_record_stopping, true);
+    xSemaphoreTake(sensor_record_done, portMAX_DELAY);
+    sensor_record_task_handle = NULL;
+
+    ring_stats_t stats;
+    ring_get_stats(&sensor_record_ring, &stats);
+    uint32_t count = sensor_recorder.count;
+    esp_err_t ret = record_writer_close(&sensor_recorder);
+    if (sensor_record_error != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Gravacao incompleta: %lu amostras gravadas, %lu nao gravadas", (unsigned long)count,
+                 (unsigned long)sensor_record_failed);
+        return sensor_record_error;
+    }
+    if (ret == ESP_OK)
+    {
+        ESP_LOGI(TAG, "Gravacao encerrada: %lu amostras, %lu perdidas, anel ate %lu", (unsigned long)count,
+                 (unsigned long)stats.dropped, (unsigned long)stats.high_water);
+    }
+    return ret;
+}
+
+// Copia a amostra mais nova sem tocar no I2C nem bloquear; false se ainda nao ha nenhuma
+bool sensor_get_latest(sensor_sample_t *out)
+{
+    while (1)
+    {
+        unsigned count = atomic_load_explicit(&sensor_published, memory_order_acquire);
+        if (count == 0)
+        {
+            return false;
+        }
+
+        sensor_slot_t *slot = &sensor_slots[(count - 1) % SENSOR_SLOTS];
+        unsigned seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (seq & 1)
+        {
+            continue;
+        }
+
+        *out = slot->sample;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->seq, memory_order_relaxed) == seq)
+        {
+            return true;
+        }
+    }
+}
+
+// ESP_ERR_NOT_FOUND sem calibracao salva; ESP_ERR_INVALID_STATE quando a temperatura
+// atual se afastou demais da registrada e a peca precisa ser recalibrada
+esp_err_t sensor_get_calibration(sensor_calibration_t *out)
+{
+    if (!sensor_calibration_loaded)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    *out = sensor_calibration;
+
+    sensor_sample_t sample;
+    if (sensor_get_latest(&sample) && fabsf(sample.temp_c - sensor_calibration.temp_c) > SENSOR_CALIBRATION_MAX_DRIFT_C)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ESP_OK;
+}
+
+// Media de SENSOR_CALIBRATION_SAMPLES amostras com a placa parada, grava na NVS e passa
+// a descontar o vies do giro. Bloqueia por ~0.3 s.
+esp_err_t sensor_calibrate(sensor_calibration_t *out)
+{
+    sensor_sample_t sample;
+    float accel_sum[3] = {0}, gyro_sum[3] = {0}, temp_sum = 0;
+    uint32_t last_seq = UINT32_MAX;
+    int valid = 0;
+
+    for (int i = 0; i < SENSOR_CALIBRATION_SAMPLES; i++)
+    {
+        vTaskDelay(1);
+        if (!sensor_get_latest(&sample) || sample.seq == last_seq)
+        {
+            continue;
+        }
+        last_seq = sample.seq;
+
+        // Descarta leituras absurdas, de um tranco ou de erro no barramento
+        if (fabsf(sample.accel_g[0]) >= 3.0f || fabsf(sample.accel_g[1]) >= 3.0f)
+        {
+            continue;
+        }
+        for (int axis = 0; axis < 3; axis++)
+        {
+            accel_sum[axis] += sample.accel_g[axis];
+            gyro_sum[axis] += MPU6050_Q16_TO_FLOAT(sample.fixed.gyro_dps[axis]);
+        }
+        temp_sum += sample.temp_c;
+        valid++;
+    }
+
+    if (valid < SENSOR_CALIBRATION_SAMPLES / 2)
+    {
+        return ESP_FAIL;
+    }
+
+    sensor_calibration_t cal = {.version = SENSOR_CALIBRATION_VERSION};
+    for (int axis = 0; axis < 3; axis++)
+    {
+        cal.accel_offset_g[axis] = accel_sum[axis] / valid;
+        cal.gyro_bias_dps[axis] = gyro_sum[axis] / valid;
+    }
+    cal.temp_c = temp_sum / valid;
+
+    sensor_calibration = cal;
+    sensor_calibration_loaded = true;
+    atomic_store_explicit(&sensor_bias_reseed, true, memory_order_release);
+    *out = cal;
+
+    esp_err_t ret = sensor_calibration_save(&cal);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Falha ao gravar calibracao: %s", esp_err_to_name(ret));
+    }
+    return ESP_OK;
+}
+
+uint32_t sensor_get_sample_count(void)
+{
+    return atomic_load_explicit(&sensor_published, memory_order_relaxed);
+}
@@ -1,66 +1,90 @@
 #ifndef _FONT_H_
 #define _FONT_H_
 
+// Glifos ASCII 32..90, uma linha por byte com o bit 0 na coluna da esquerda.
+// A lista e expandida duas vezes: como esta (font8x8_basic) e transposta para o
+// formato de paginas do SSD1306 (font8x8_basic_pages), um byte por coluna com o
+// bit 0 na linha de cima. A transposicao e feita pelo compilador.
+#define FONT8X8_BASIC_GLYPHS(G) \
+    G(0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00) \
+    G(0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00) \
+    G(0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00) \
+    G(0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00) \
+    G(0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00) \
+    G(0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00) \
+    G(0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00) \
+    G(0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00) \
+    G(0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00) \
+    G(0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00) \
+    G(0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00) \
+    G(0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00) \
+    G(0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x06, 0x00) \
+    G(0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00) \
+    G(0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00) \
+    G(0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00) \
+    G(0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00) \
+    G(0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00) \
+    G(0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00) \
+    G(0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00) \
+    G(0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00) \
+    G(0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00) \
+    G(0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00) \
+    G(0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00) \
+    G(0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00) \
+    G(0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00) \
+    G(0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00) \
+    G(0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x06, 0x00) \
+    G(0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00) \
+    G(0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00) \
+    G(0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00) \
+    G(0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00) \
+    G(0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00) \
+    G(0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00) \
+    G(0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00) \
+    G(0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00) \
+    G(0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00) \
+    G(0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00) \
+    G(0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00) \
+    G(0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00) \
+    G(0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00) \
+    G(0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00) \
+    G(0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00) \
+    G(0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00) \
+    G(0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00) \
+    G(0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00) \
+    G(0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00) \
+    G(0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00) \
+    G(0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00) \
+    G(0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00) \
+    G(0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00) \
+    G(0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00) \
+    G(0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00) \
+    G(0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00) \
+    G(0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00) \
+    G(0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00) \
+    G(0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00) \
+    G(0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00) \
+    G(0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00)
+
+#define FONT8X8_ROWS(r0, r1, r2, r3, r4, r5, r6, r7) {r0, r1, r2, r3, r4, r5, r6, r7},
+
+#define FONT8X8_BIT(row, col, n)    ((((row) >> (col)) & 1) << (n))
+#define FONT8X8_COL(col, r0, r1, r2, r3, r4, r5, r6, r7) \
+    (FONT8X8_BIT(r0, col, 0) | FONT8X8_BIT(r1, col, 1) | FONT8X8_BIT(r2, col, 2) | FONT8X8_BIT(r3, col, 3) | \
+     FONT8X8_BIT(r4, col, 4) | FONT8X8_BIT(r5, col, 5) | FONT8X8_BIT(r6, col, 6) | FONT8X8_BIT(r7, col, 7))
+#define FONT8X8_PAGES(...) { \
+    FONT8X8_COL(0, __VA_ARGS__), FONT8X8_COL(1, __VA_ARGS__), FONT8X8_COL(2, __VA_ARGS__), FONT8X8_COL(3, __VA_ARGS__), \
+    FONT8X8_COL(4, __VA_ARGS__), FONT8X8_COL(5, __VA_ARGS__), FONT8X8_COL(6, __VA_ARGS__), FONT8X8_COL(7, __VA_ARGS__) },
+
 static const uint8_t font8x8_basic[][8] = {
-    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},   
-    {0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00},   
-    {0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},   
-    {0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00},   
-    {0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00},   
-    {0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00},   
-    {0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00},  
-    {0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00},   
-    {0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00},   
-    {0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00},   
-    {0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00},   
-    {0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00},   
-    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x06, 0x00},   
-    {0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00},   
-    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00},   
-    {0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00},   
-    {0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00},   
-    {0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00},   
-    {0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00},   
-    {0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00},   
-    {0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00},   
-    {0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00},   
-    {0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00},   
-    {0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00},   
-    {0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00},   
-    {0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00},   
-    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00},   
-    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x06, 0x00},   
-    {0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00},   
-    {0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00},   
-    {0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00},   
-    {0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00},   
-    {0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00},   
-    {0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00},  
-    {0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00},   
-    {0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00},   
-    {0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00},   
-    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00},   
-    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00},   
-    {0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00},   
-    {0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00},   
-    {0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00},   
-    {0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00},   
-    {0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00},   
-    {0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00},   
-    {0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00},  
-    {0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00},  
-    {0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00},   
-    {0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00},   
-    {0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00},   
-    {0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00},   
-    {0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00},   
-    {0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00},   
-    {0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00},   
-    {0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00},  
-    {0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00},   
-    {0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00},   
-    {0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00},   
-    {0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00}    
+    FONT8X8_BASIC_GLYPHS(FONT8X8_ROWS)
 };
 
-#endif 
\ No newline at end of file
+static const uint8_t font8x8_basic_pages[][8] = {
+    FONT8X8_BASIC_GLYPHS(FONT8X8_PAGES)
+};
+
+#define FONT8X8_FIRST_CHAR  32
+#define FONT8X8_GLYPH_COUNT (sizeof(font8x8_basic_pages) / sizeof(font8x8_basic_pages[0]))
+
+#endif
\ No newline at end of file
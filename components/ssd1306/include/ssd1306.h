@@ -34,12 +34,43 @@
 #define SSD1306_CMD_SET_COLUMN_ADDR 0x21
 #define SSD1306_CMD_SET_PAGE_ADDR   0x22
 
+// A folha de dados especifica 400 kHz, mas a maioria dos modulos aceita 1 MHz;
+// a negociacao no i2clib desce ate a velocidade que funcionar
+#define SSD1306_MAX_SPEED_HZ        I2C_SPEED_FAST_PLUS_HZ
+#define SSD1306_TIMEOUT_MS          20  // um bloco de uma pagina leva ~12 ms a 100 kHz
+
+#define SSD1306_FLUSH_TASK_CORE     1
+#define SSD1306_FLUSH_TASK_PRIORITY 5
+#define SSD1306_FLUSH_TASK_STACK    3072
+
+typedef struct {
+    uint32_t bytes_sent;        // bytes transmitidos apos o endereco (controle + comandos + dados)
+    uint32_t frames;            // quadros enviados ao display
+    uint32_t frames_presented;  // quadros entregues para envio
+    uint32_t frames_dropped;    // present() descartados porque o quadro anterior ainda estava sendo enviado
+    uint32_t frames_in_flight;  // quadros entregues e ainda nao enviados (0 ou 1)
+    uint32_t transactions;      // transacoes I2C concluidas (comandos e dados)
+    uint32_t init_time_us;      // duracao da sequencia de inicializacao
+} ssd1306_stats_t;
+
+esp_err_t ssd1306_write_commands(const uint8_t *cmds, size_t len);
 esp_err_t ssd1306_write_command(uint8_t cmd);
 esp_err_t ssd1306_write_data(uint8_t* data, size_t len);
+esp_err_t ssd1306_write_data_async(uint8_t *data, size_t len, i2c_request_t *req, i2c_done_cb_t cb, void *cb_arg);
+esp_err_t ssd1306_set_contrast(uint8_t contrast);
 void ssd1306_init(void);
 void ssd1306_clear_buffer(void);
 void ssd1306_update_display(void);
+esp_err_t ssd1306_start_flush_task(void);
+bool ssd1306_present(void);
+void ssd1306_present_blocking(void);
+void ssd1306_force_full_refresh(void);
+void ssd1306_get_stats(ssd1306_stats_t *stats);
+void ssd1306_reset_stats(void);
 void ssd1306_set_pixel(int x, int y, bool on);
+void ssd1306_fill_rect(int x, int y, int w, int h, bool on);
+void ssd1306_draw_hline(int x, int y, int w);
+void ssd1306_draw_vline(int x, int y, int h);
 void ssd1306_draw_circle_points(int cx, int cy, int x, int y);
 void ssd1306_draw_circle(int cx, int cy, int radius, bool filled);
 void ssd1306_draw_char(int x, int y, char c);
@@ -1,109 +1,470 @@
 #include "ssd1306.h"
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
 
+// Back buffer: e onde todas as rotinas de desenho escrevem
 static uint8_t ssd1306_buffer[SSD1306_WIDTH * SSD1306_HEIGHT / SSD1306_PAGES];
 
-esp_err_t ssd1306_write_command(uint8_t cmd) {
-  i2c_cmd_handle_t cmd_link = i2c_cmd_link_create();
-  i2c_master_start(cmd_link);
-  i2c_master_write_byte(cmd_link, (SSD1306_I2C_ADDR << 1) | I2C_MASTER_WRITE, true);
-  i2c_master_write_byte(cmd_link, 0x00, true); 
-  i2c_master_write_byte(cmd_link, cmd, true);
-  i2c_master_stop(cmd_link);
-  esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd_link, I2C_MASTER_TIMEOUT_MS / portTICK_PERIOD_MS);
-  i2c_cmd_link_delete(cmd_link);
+// Front buffer: o quadro entregue ao envio. Com o envio ocioso ele e identico a GDDRAM,
+// entao tambem serve para descartar bytes que nao mudaram
+static uint8_t ssd1306_front[SSD1306_WIDTH * SSD1306_HEIGHT / SSD1306_PAGES];
+
+// Janelas do quadro travado no front buffer, aguardando envio
+static int flush_start[SSD1306_PAGES];
+static int flush_end[SSD1306_PAGES];
+
+static TaskHandle_t flush_task_handle = NULL;
+static SemaphoreHandle_t flush_done = NULL;
+static atomic_int frames_in_flight = 0;
+
+// Faixa de colunas [start, end] alterada desde o ultimo envio (start > end = pagina limpa)
+static uint8_t dirty_start[SSD1306_PAGES];
+static uint8_t dirty_end[SSD1306_PAGES];
+
+// Faixa de colunas com pixels acesos desde o ultimo clear, para o clear so apagar o necessario
+static uint8_t ink_start[SSD1306_PAGES];
+static uint8_t ink_end[SSD1306_PAGES];
+
+// A GDDRAM tem conteudo aleatorio apos o reset, entao o primeiro envio e sempre completo.
+// Marcado pelo jogo, pelo envio e pela tarefa de saude do i2clib (reinit); so o latch
+// consome, com exchange, para um pedido feito durante o envio valer no proximo quadro.
+static atomic_bool full_refresh_pending = true;
+
+// Contadores somados de varias tarefas; ssd1306_get_stats monta o ssd1306_stats_t
+static struct {
+  atomic_uint bytes_sent;
+  atomic_uint frames;
+  atomic_uint frames_presented;
+  atomic_uint frames_dropped;
+  atomic_uint transactions;
+  uint32_t init_time_us;
+} ssd1306_stats;
+
+static const char *TAG = "SSD1306";
+
+static i2c_device_handle_t ssd1306_dev = NULL;
+
+static const uint8_t ssd1306_init_sequence[] = {
+  SSD1306_CMD_DISPLAY_OFF,
+  SSD1306_CMD_SET_CLOCK_DIV, 0x80,
+  SSD1306_CMD_SET_MULTIPLEX, 0x3F,
+  SSD1306_CMD_SET_DISPLAY_OFFSET, 0x00,
+  SSD1306_CMD_SET_START_LINE | 0x00,
+  SSD1306_CMD_CHARGE_PUMP, 0x14,
+  SSD1306_CMD_MEMORY_MODE, 0x00,
+  SSD1306_CMD_SEGMENT_REMAP | 0x01,
+  SSD1306_CMD_COM_SCAN_DEC,
+  SSD1306_CMD_SET_COM_PINS, 0x12,
+  SSD1306_CMD_SET_CONTRAST, 0xCF,
+  SSD1306_CMD_SET_PRECHARGE, 0xF1,
+  SSD1306_CMD_SET_VCOM_DETECT, 0x40,
+  SSD1306_CMD_ENTIRE_DISPLAY_ON,
+  SSD1306_CMD_NORMAL_DISPLAY,
+  SSD1306_CMD_DISPLAY_ON,
+};
+
+static inline void ssd1306_count(atomic_uint *counter, uint32_t n) {
+  atomic_fetch_add_explicit(counter, n, memory_order_relaxed);
+}
+
+static inline void ssd1306_count_transfer(size_t len) {
+  ssd1306_count(&ssd1306_stats.bytes_sent, len + 1);
+  ssd1306_count(&ssd1306_stats.transactions, 1);
+}
+
+static inline void ssd1306_mark_dirty(int page, int x0, int x1) {
+  if (x0 < dirty_start[page]) dirty_start[page] = x0;
+  if (x1 > dirty_end[page]) dirty_end[page] = x1;
+}
+
+static inline void ssd1306_mark_ink(int page, int x0, int x1) {
+  if (x0 < ink_start[page]) ink_start[page] = x0;
+  if (x1 > ink_end[page]) ink_end[page] = x1;
+}
+
+static void ssd1306_reset_dirty(void) {
+  memset(dirty_start, SSD1306_WIDTH, sizeof(dirty_start));
+  memset(dirty_end, 0, sizeof(dirty_end));
+}
+
+static void ssd1306_reset_ink(void) {
+  memset(ink_start, SSD1306_WIDTH, sizeof(ink_start));
+  memset(ink_end, 0, sizeof(ink_end));
+}
+
+static void ssd1306_mark_all(void) {
+  for (int page = 0; page < SSD1306_PAGES; page++) {
+    ssd1306_mark_dirty(page, 0, SSD1306_WIDTH - 1);
+    ssd1306_mark_ink(page, 0, SSD1306_WIDTH - 1);
+  }
+}
+
+esp_err_t ssd1306_write_commands(const uint8_t *cmds, size_t len) {
+  const uint8_t control = 0x00;
+  esp_err_t ret = i2c_device_transmit(ssd1306_dev, &control, 1, cmds, len);
+  if (ret == ESP_OK) {
+    ssd1306_count_transfer(len);
+  }
   return ret;
 }
 
+esp_err_t ssd1306_write_command(uint8_t cmd) {
+  return ssd1306_write_commands(&cmd, 1);
+}
+
 esp_err_t ssd1306_write_data(uint8_t* data, size_t len) {
-  i2c_cmd_handle_t cmd_link = i2c_cmd_link_create();
-  i2c_master_start(cmd_link);
-  i2c_master_write_byte(cmd_link, (SSD1306_I2C_ADDR << 1) | I2C_MASTER_WRITE, true);
-  i2c_master_write_byte(cmd_link, 0x40, true); 
-  i2c_master_write(cmd_link, data, len, true);
-  i2c_master_stop(cmd_link);
-  esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd_link, I2C_MASTER_TIMEOUT_MS / portTICK_PERIOD_MS);
-  i2c_cmd_link_delete(cmd_link);
+  const uint8_t control = 0x40;
+  esp_err_t ret = i2c_device_transmit(ssd1306_dev, &control, 1, data, len);
+  if (ret == ESP_OK) {
+    ssd1306_count_transfer(len);
+  }
+  return ret;
+}
+
+// Retorna assim que o envio entra na fila; data precisa continuar valido ate req terminar.
+// As estatisticas contam o envio ao enfileirar.
+esp_err_t ssd1306_write_data_async(uint8_t *data, size_t len, i2c_request_t *req, i2c_done_cb_t cb, void *cb_arg) {
+  const uint8_t control = 0x40;
+  esp_err_t ret = i2c_device_transmit_async(ssd1306_dev, req, &control, 1, data, len, cb, cb_arg);
+  if (ret == ESP_OK) {
+    ssd1306_count_transfer(len);
+  }
+  return ret;
+}
+
+esp_err_t ssd1306_set_contrast(uint8_t contrast) {
+  const uint8_t cmds[] = {SSD1306_CMD_SET_CONTRAST, contrast};
+  return ssd1306_write_commands(cmds, sizeof(cmds));
+}
+
+// Chamada pelo i2clib depois de uma recuperacao do barramento: o controlador pode ter
+// perdido a configuracao e a GDDRAM, entao o proximo quadro sai completo
+static esp_err_t ssd1306_reinit(void) {
+  esp_err_t ret = ssd1306_write_commands(ssd1306_init_sequence, sizeof(ssd1306_init_sequence));
+  ssd1306_force_full_refresh();
   return ret;
 }
 
 void ssd1306_init(void) {
-  ssd1306_write_command(SSD1306_CMD_DISPLAY_OFF);
-  ssd1306_write_command(SSD1306_CMD_SET_CLOCK_DIV);
-  ssd1306_write_command(0x80);
-  ssd1306_write_command(SSD1306_CMD_SET_MULTIPLEX);
-  ssd1306_write_command(0x3F);
-  ssd1306_write_command(SSD1306_CMD_SET_DISPLAY_OFFSET);
-  ssd1306_write_command(0x00);
-  ssd1306_write_command(SSD1306_CMD_SET_START_LINE | 0x00);
-  ssd1306_write_command(SSD1306_CMD_CHARGE_PUMP);
-  ssd1306_write_command(0x14);
-  ssd1306_write_command(SSD1306_CMD_MEMORY_MODE);
-  ssd1306_write_command(0x00);
-
-  ssd1306_write_command(SSD1306_CMD_SEGMENT_REMAP | 0x01);
-  ssd1306_write_command(SSD1306_CMD_COM_SCAN_DEC);
-  ssd1306_write_command(SSD1306_CMD_SET_COM_PINS);
-  ssd1306_write_command(0x12);
-  ssd1306_write_command(SSD1306_CMD_SET_CONTRAST);
-  ssd1306_write_command(0xCF);
-  ssd1306_write_command(SSD1306_CMD_SET_PRECHARGE);
-  ssd1306_write_command(0xF1);
-  ssd1306_write_command(SSD1306_CMD_SET_VCOM_DETECT);
-  ssd1306_write_command(0x40);
-  ssd1306_write_command(SSD1306_CMD_ENTIRE_DISPLAY_ON);
-  ssd1306_write_command(SSD1306_CMD_NORMAL_DISPLAY);
-  ssd1306_write_command(SSD1306_CMD_DISPLAY_ON);
+  ssd1306_reset_dirty();
+  ssd1306_reset_ink();
+  atomic_store(&full_refresh_pending, true);
+
+  const i2c_device_desc_t dev_desc = {
+    .addr = SSD1306_I2C_ADDR,
+    .max_speed_hz = SSD1306_MAX_SPEED_HZ,
+    .probe_reg = I2C_PROBE_ACK_ONLY,
+    .priority = I2C_PRIORITY_LOW,
+    .chunk_size = SSD1306_WIDTH,  // uma pagina por bloco, leituras do sensor entram entre as paginas
+    .timeout_ms = SSD1306_TIMEOUT_MS,
+    .reinit = ssd1306_reinit,
+  };
+  if (i2c_device_register(&dev_desc, &ssd1306_dev) != ESP_OK) {
+    ESP_LOGE(TAG, "Display nao respondeu na negociacao de velocidade");
+  }
+
+  int64_t start = esp_timer_get_time();
+  esp_err_t ret = ssd1306_write_commands(ssd1306_init_sequence, sizeof(ssd1306_init_sequence));
+  ssd1306_stats.init_time_us = esp_timer_get_time() - start;
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "Falha na inicializacao: %s", esp_err_to_name(ret));
+  } else {
+    ESP_LOGI(TAG, "Inicializado em %lu us", (unsigned long)ssd1306_stats.init_time_us);
+  }
 
   vTaskDelay(pdMS_TO_TICKS(10));
 }
 
 void ssd1306_clear_buffer(void) {
-  memset(ssd1306_buffer, 0x00, sizeof(ssd1306_buffer));
+  for (int page = 0; page < SSD1306_PAGES; page++) {
+    if (ink_start[page] > ink_end[page]) continue;
+    memset(&ssd1306_buffer[page * SSD1306_WIDTH + ink_start[page]], 0x00, ink_end[page] - ink_start[page] + 1);
+    ssd1306_mark_dirty(page, ink_start[page], ink_end[page]);
+  }
+  ssd1306_reset_ink();
+}
+
+static esp_err_t ssd1306_send_window(int col_start, int col_end, int page_start, int page_end) {
+  const uint8_t window[] = {
+    SSD1306_CMD_SET_COLUMN_ADDR, col_start, col_end,
+    SSD1306_CMD_SET_PAGE_ADDR, page_start, page_end,
+  };
+  esp_err_t ret = ssd1306_write_commands(window, sizeof(window));
+  if (ret != ESP_OK) {
+    return ret;
+  }
+
+  // Janela da largura toda e contigua no front buffer: sai numa so chamada e o
+  // arbitro do barramento divide em blocos de uma pagina
+  int width = col_end - col_start + 1;
+  if (width == SSD1306_WIDTH) {
+    return ssd1306_write_data(&ssd1306_front[page_start * SSD1306_WIDTH], width * (page_end - page_start + 1));
+  }
+  for (int page = page_start; page <= page_end; page++) {
+    ret = ssd1306_write_data(&ssd1306_front[page * SSD1306_WIDTH + col_start], width);
+    if (ret != ESP_OK) {
+      return ret;
+    }
+  }
+  return ESP_OK;
+}
+
+// Copia as faixas sujas do back buffer para o front buffer e guarda as janelas a enviar.
+// So pode ser chamada com o envio ocioso.
+static void ssd1306_latch_frame(void) {
+  bool full = atomic_exchange(&full_refresh_pending, false);
+  for (int page = 0; page < SSD1306_PAGES; page++) {
+    int s;
+    int e;
+    if (full) {
+      s = 0;
+      e = SSD1306_WIDTH - 1;
+    } else {
+      // Descarta nas bordas da faixa suja os bytes iguais ao que o display ja mostra
+      const uint8_t *back = &ssd1306_buffer[page * SSD1306_WIDTH];
+      const uint8_t *front = &ssd1306_front[page * SSD1306_WIDTH];
+      s = dirty_start[page];
+      e = dirty_end[page];
+      while (s <= e && back[s] == front[s]) s++;
+      while (e >= s && back[e] == front[e]) e--;
+    }
+    if (s <= e) {
+      memcpy(&ssd1306_front[page * SSD1306_WIDTH + s], &ssd1306_buffer[page * SSD1306_WIDTH + s], e - s + 1);
+    }
+    flush_start[page] = s;
+    flush_end[page] = e;
+  }
+  ssd1306_reset_dirty();
+}
+
+static void ssd1306_flush_latched(void) {
+  // Paginas consecutivas com a mesma faixa vao numa unica janela
+  esp_err_t ret = ESP_OK;
+  int page = 0;
+  while (page < SSD1306_PAGES) {
+    if (flush_start[page] > flush_end[page]) {
+      page++;
+      continue;
+    }
+    int last = page;
+    while (last + 1 < SSD1306_PAGES && flush_start[last + 1] == flush_start[page] && flush_end[last + 1] == flush_end[page]) {
+      last++;
+    }
+    if (ssd1306_send_window(flush_start[page], flush_end[page], page, last) != ESP_OK) {
+      ret = ESP_FAIL;
+    }
+    page = last + 1;
+  }
+
+  // Em caso de falha o estado da GDDRAM e incerto, entao o proximo envio e completo
+  if (ret != ESP_OK) {
+    atomic_store(&full_refresh_pending, true);
+  }
+  ssd1306_count(&ssd1306_stats.frames, 1);
+}
+
+static void ssd1306_flush_task(void *pvParameters) {
+  while (1) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    ssd1306_flush_latched();
+    atomic_store(&frames_in_flight, 0);
+    xSemaphoreGive(flush_done);
+  }
+}
+
+esp_err_t ssd1306_start_flush_task(void) {
+  if (flush_task_handle != NULL) {
+    return ESP_OK;
+  }
+
+  flush_done = xSemaphoreCreateBinary();
+  if (flush_done == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+
+  BaseType_t core = (portNUM_PROCESSORS > 1) ? SSD1306_FLUSH_TASK_CORE : tskNO_AFFINITY;
+  if (xTaskCreatePinnedToCore(ssd1306_flush_task, "ssd1306_flush", SSD1306_FLUSH_TASK_STACK, NULL,
+                              SSD1306_FLUSH_TASK_PRIORITY, &flush_task_handle, core) != pdPASS) {
+    vSemaphoreDelete(flush_done);
+    flush_done = NULL;
+    flush_task_handle = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+  return ESP_OK;
+}
+
+static void ssd1306_wait_flush(void) {
+  while (atomic_load(&frames_in_flight) != 0) {
+    xSemaphoreTake(flush_done, portMAX_DELAY);
+  }
+}
+
+bool ssd1306_present(void) {
+  if (flush_task_handle == NULL) {
+    ssd1306_update_display();
+    return true;
+  }
+
+  if (atomic_load(&frames_in_flight) != 0) {
+    // O quadro anterior ainda esta no barramento; as faixas sujas continuam marcadas
+    // no back buffer e saem junto com o proximo present
+    ssd1306_count(&ssd1306_stats.frames_dropped, 1);
+    return false;
+  }
+
+  ssd1306_latch_frame();
+  atomic_store(&frames_in_flight, 1);
+  ssd1306_count(&ssd1306_stats.frames_presented, 1);
+  xTaskNotifyGive(flush_task_handle);
+  return true;
+}
+
+void ssd1306_present_blocking(void) {
+  if (flush_task_handle == NULL) {
+    ssd1306_update_display();
+    return;
+  }
+
+  ssd1306_wait_flush();
+  ssd1306_present();
+  ssd1306_wait_flush();
 }
 
 void ssd1306_update_display(void) {
-  ssd1306_write_command(SSD1306_CMD_SET_COLUMN_ADDR);
-  ssd1306_write_command(0);
-  ssd1306_write_command(127);
-  ssd1306_write_command(SSD1306_CMD_SET_PAGE_ADDR);
-  ssd1306_write_command(0);
-  ssd1306_write_command(7);
+  if (flush_task_handle != NULL) {
+    ssd1306_present_blocking();
+    return;
+  }
+
+  ssd1306_latch_frame();
+  ssd1306_count(&ssd1306_stats.frames_presented, 1);
+  ssd1306_flush_latched();
+}
 
-  esp_err_t ret = ssd1306_write_data(ssd1306_buffer, sizeof(ssd1306_buffer));
+void ssd1306_force_full_refresh(void) {
+  atomic_store(&full_refresh_pending, true);
+}
+
+void ssd1306_get_stats(ssd1306_stats_t *stats) {
+  *stats = (ssd1306_stats_t){
+    .bytes_sent = atomic_load_explicit(&ssd1306_stats.bytes_sent, memory_order_relaxed),
+    .frames = atomic_load_explicit(&ssd1306_stats.frames, memory_order_relaxed),
+    .frames_presented = atomic_load_explicit(&ssd1306_stats.frames_presented, memory_order_relaxed),
+    .frames_dropped = atomic_load_explicit(&ssd1306_stats.frames_dropped, memory_order_relaxed),
+    .frames_in_flight = atomic_load(&frames_in_flight),
+    .transactions = atomic_load_explicit(&ssd1306_stats.transactions, memory_order_relaxed),
+    .init_time_us = ssd1306_stats.init_time_us,
+  };
+}
+
+// O init_time_us e medido uma vez so e sobrevive ao reset
+void ssd1306_reset_stats(void) {
+  atomic_store(&ssd1306_stats.bytes_sent, 0);
+  atomic_store(&ssd1306_stats.frames, 0);
+  atomic_store(&ssd1306_stats.frames_presented, 0);
+  atomic_store(&ssd1306_stats.frames_dropped, 0);
+  atomic_store(&ssd1306_stats.transactions, 0);
 }
 
 void ssd1306_test_pattern(void) {
   memset(ssd1306_buffer, 0xFF, sizeof(ssd1306_buffer));
+  ssd1306_mark_all();
   ssd1306_update_display();
   vTaskDelay(pdMS_TO_TICKS(3000));
   
   memset(ssd1306_buffer, 0x00, sizeof(ssd1306_buffer));
+  ssd1306_mark_all();
   ssd1306_update_display();
   vTaskDelay(pdMS_TO_TICKS(3000));
   
   for (int i = 0; i < sizeof(ssd1306_buffer); i++) {
     ssd1306_buffer[i] = (i % 2) ? 0xAA : 0x55;
   }
+  ssd1306_mark_all();
   ssd1306_update_display();
   vTaskDelay(pdMS_TO_TICKS(3000));
   
   for (int i = 0; i < sizeof(ssd1306_buffer); i++) {
     ssd1306_buffer[i] = 0x0F; 
   }
+  ssd1306_mark_all();
   ssd1306_update_display();
   vTaskDelay(pdMS_TO_TICKS(3000));
 }
 
+// Bits de uma pagina a partir da linha n (inclusive) e ate a linha n (inclusive)
+static const uint8_t page_mask_from[8] = {0xFF, 0xFE, 0xFC, 0xF8, 0xF0, 0xE0, 0xC0, 0x80};
+static const uint8_t page_mask_to[8] = {0x01, 0x03, 0x07, 0x0F, 0x1F, 0x3F, 0x7F, 0xFF};
+
+// Preenche o retangulo [x0, x1] x [y0, y1], ja recortado, byte a byte em cada pagina
+static void ssd1306_fill_span(int x0, int x1, int y0, int y1, bool on) {
+  int page0 = y0 >> 3;
+  int page1 = y1 >> 3;
+  int width = x1 - x0 + 1;
+
+  for (int page = page0; page <= page1; page++) {
+    uint8_t mask = 0xFF;
+    if (page == page0) mask &= page_mask_from[y0 & 7];
+    if (page == page1) mask &= page_mask_to[y1 & 7];
+
+    uint8_t *p = &ssd1306_buffer[page * SSD1306_WIDTH + x0];
+    if (on) {
+      for (int i = 0; i < width; i++) {
+        p[i] |= mask;
+      }
+      ssd1306_mark_ink(page, x0, x1);
+    } else {
+      mask = ~mask;
+      for (int i = 0; i < width; i++) {
+        p[i] &= mask;
+      }
+    }
+    ssd1306_mark_dirty(page, x0, x1);
+  }
+}
+
+// Recorta o retangulo [x0, x1] x [y0, y1] contra a tela; retorna false se nada sobrar
+static inline bool ssd1306_clip(int *x0, int *x1, int *y0, int *y1) {
+  if (*x0 < 0) *x0 = 0;
+  if (*y0 < 0) *y0 = 0;
+  if (*x1 > SSD1306_WIDTH - 1) *x1 = SSD1306_WIDTH - 1;
+  if (*y1 > SSD1306_HEIGHT - 1) *y1 = SSD1306_HEIGHT - 1;
+  return *x0 <= *x1 && *y0 <= *y1;
+}
+
 void ssd1306_set_pixel(int x, int y, bool on) {
   if (x >= 0 && x < SSD1306_WIDTH && y >= 0 && y < SSD1306_HEIGHT) {
+    int page = y >> 3;
     if (on) {
-      ssd1306_buffer[x + (y / SSD1306_FONT_WIDTH) * SSD1306_WIDTH] |= (1 << (y % SSD1306_FONT_WIDTH));
+      ssd1306_buffer[x + page * SSD1306_WIDTH] |= (1 << (y & 7));
+      ssd1306_mark_ink(page, x, x);
     } else {
-      ssd1306_buffer[x + (y / SSD1306_FONT_WIDTH) * SSD1306_WIDTH] &= ~(1 << (y % SSD1306_FONT_WIDTH));
+      ssd1306_buffer[x + page * SSD1306_WIDTH] &= ~(1 << (y & 7));
     }
+    ssd1306_mark_dirty(page, x, x);
   }
 }
 
+void ssd1306_fill_rect(int x, int y, int w, int h, bool on) {
+  int x0 = x;
+  int x1 = x + w - 1;
+  int y0 = y;
+  int y1 = y + h - 1;
+  if (ssd1306_clip(&x0, &x1, &y0, &y1)) {
+    ssd1306_fill_span(x0, x1, y0, y1, on);
+  }
+}
+
+void ssd1306_draw_hline(int x, int y, int w) {
+  ssd1306_fill_rect(x, y, w, 1, true);
+}
+
+void ssd1306_draw_vline(int x, int y, int h) {
+  ssd1306_fill_rect(x, y, 1, h, true);
+}
+
 void ssd1306_draw_circle_points(int cx, int cy, int x, int y) {
     ssd1306_set_pixel(cx + x, cy + y, true);
     ssd1306_set_pixel(cx - x, cy + y, true);
@@ -117,11 +478,15 @@ void ssd1306_draw_circle_points(int cx, int cy, int x, int y) {
 
 void ssd1306_draw_circle(int cx, int cy, int radius, bool filled) {
     if (filled) {
-        for (int y = -radius; y <= radius; y++) {
-            for (int x = -radius; x <= radius; x++) {
-                if (x * x + y * y <= radius * radius) {
-                    ssd1306_set_pixel(cx + x, cy + y, true);
-                }
+        // Uma coluna vertical por x, com meia altura h = maior valor com x^2 + h^2 <= r^2
+        int h = radius;
+        for (int x = 0; x <= radius; x++) {
+            while (x * x + h * h > radius * radius) {
+                h--;
+            }
+            ssd1306_draw_vline(cx + x, cy - h, 2 * h + 1);
+            if (x != 0) {
+                ssd1306_draw_vline(cx - x, cy - h, 2 * h + 1);
             }
         }
     } else {
@@ -147,15 +512,46 @@ void ssd1306_draw_circle(int cx, int cy, int radius, bool filled) {
 }
 
 void ssd1306_draw_char(int x, int y, char c) {
-    if (c < 32 || c > 126) c = 32;
-    int index = c - 32;
-
-    for (int i = 0; i < SSD1306_FONT_WIDTH; i++) {
-        uint8_t line = font8x8_basic[index][i];
-        for (int j = 0; j < SSD1306_FONT_WIDTH; j++) {
-            bool pixel = line & (1 << j);
-            ssd1306_set_pixel(x + j, y + i, pixel);
+    if (c < FONT8X8_FIRST_CHAR || c >= FONT8X8_FIRST_CHAR + (int)FONT8X8_GLYPH_COUNT) c = ' ';
+    const uint8_t *glyph = font8x8_basic_pages[c - FONT8X8_FIRST_CHAR];
+
+    int x0 = x < 0 ? 0 : x;
+    int x1 = x + SSD1306_FONT_WIDTH - 1;
+    if (x1 > SSD1306_WIDTH - 1) x1 = SSD1306_WIDTH - 1;
+    if (x0 > x1 || y <= -SSD1306_FONT_WIDTH || y >= SSD1306_HEIGHT) return;
+
+    int page = y >> 3;
+    int shift = y & 7;
+
+    if (shift == 0) {
+        // Alinhado a pagina: um byte do glifo por coluna
+        uint8_t *p = &ssd1306_buffer[page * SSD1306_WIDTH];
+        for (int col = x0; col <= x1; col++) {
+            p[col] = glyph[col - x];
+        }
+        ssd1306_mark_dirty(page, x0, x1);
+        ssd1306_mark_ink(page, x0, x1);
+        return;
+    }
+
+    // Desalinhado: o glifo ocupa a parte de baixo de uma pagina e a de cima da seguinte
+    if (page >= 0) {
+        uint8_t keep = ~(0xFF << shift);
+        uint8_t *p = &ssd1306_buffer[page * SSD1306_WIDTH];
+        for (int col = x0; col <= x1; col++) {
+            p[col] = (p[col] & keep) | (uint8_t)(glyph[col - x] << shift);
+        }
+        ssd1306_mark_dirty(page, x0, x1);
+        ssd1306_mark_ink(page, x0, x1);
+    }
+    if (page + 1 < SSD1306_PAGES) {
+        uint8_t keep = ~(0xFF >> (8 - shift));
+        uint8_t *p = &ssd1306_buffer[(page + 1) * SSD1306_WIDTH];
+        for (int col = x0; col <= x1; col++) {
+            p[col] = (p[col] & keep) | (glyph[col - x] >> (8 - shift));
         }
+        ssd1306_mark_dirty(page + 1, x0, x1);
+        ssd1306_mark_ink(page + 1, x0, x1);
     }
 }
 
@@ -167,7 +563,23 @@ void ssd1306_draw_string(int x, int y, const char* str) {
   }
 }
 
+int ssd1306_get_string_width(const char *str) {
+  if (str == NULL) {
+    return 0;
+  }
+  return strlen(str) * SSD1306_FONT_WIDTH;
+}
+
 void ssd1306_draw_line(int x0, int y0, int x1, int y1) {
+  if (y0 == y1) {
+    ssd1306_draw_hline(x0 < x1 ? x0 : x1, y0, abs(x1 - x0) + 1);
+    return;
+  }
+  if (x0 == x1) {
+    ssd1306_draw_vline(x0, y0 < y1 ? y0 : y1, abs(y1 - y0) + 1);
+    return;
+  }
+
   int dx = abs(x1 - x0);
   int dy = abs(y1 - y0);
   int sx = (x0 < x1) ? 1 : -1;
@@ -193,11 +605,7 @@ void ssd1306_draw_line(int x0, int y0, int x1, int y1) {
 
 void ssd1306_draw_rect(int x, int y, int w, int h, bool filled) {
   if (filled) {
-    for (int i = x; i < x + w; i++) {
-      for (int j = y; j < y + h; j++) {
-        ssd1306_set_pixel(i, j, true);
-      }
-    }
+    ssd1306_fill_rect(x, y, w, h, true);
   } else {
     ssd1306_draw_line(x, y, x + w - 1, y);
     ssd1306_draw_line(x + w - 1, y, x + w - 1, y + h - 1);
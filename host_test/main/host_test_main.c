@@ -0,0 +1,333 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+#include "driver/i2c_master.h"
+#include "i2clib.h"
+#include "i2c_emu.h"
+#include "mpu6050.h"
+#include "mpu6050_emu.h"
+#include "record.h"
+#include "sensor.h"
+
+static const char *TAG = "HOST_TEST";
+
+#define HOST_TEST_DIRECT_TRANSACTIONS   1000000 // leituras direto no barramento emulado
+#define HOST_TEST_ARBITER_READS         200000  // leituras pelo arbitro do i2clib
+#define HOST_TEST_RECOVERY_TIMEOUT_MS   2000
+#define HOST_TEST_REINIT_SETTLE_MS      300     // o reinit do mpu6050 espera 100 ms depois do reset
+#define HOST_TEST_SAMPLING_MS           500
+#define HOST_TEST_FIFO_SAMPLES          10
+#define HOST_TEST_RECORD_MS             1000
+#define HOST_TEST_RECORD_PATH           "/tmp/mpu6050_host_test.rec"
+#define HOST_TEST_REPLAY_TIMEOUT_MS     2000
+
+static int host_test_failures = 0;
+
+static void host_test_check(const char *name, bool ok) {
+    if (ok) {
+        ESP_LOGI(TAG, "OK: %s", name);
+    } else {
+        ESP_LOGE(TAG, "FALHOU: %s", name);
+        host_test_failures++;
+    }
+}
+
+static double host_test_rate(uint32_t transactions, int64_t elapsed_us) {
+    return elapsed_us > 0 ? transactions * 1e6 / elapsed_us : 0.0;
+}
+
+// Leituras de 14 bytes direto no i2c_master emulado, sem arbitro nem filas: mede o
+// proprio emulador, num controlador separado do que o i2clib usa
+static void host_test_direct_bench(void) {
+    const i2c_master_bus_config_t bus_config = {
+        .i2c_port = I2C_SECONDARY_NUM,
+        .sda_io_num = I2C_SECONDARY_SDA_IO,
+        .scl_io_num = I2C_SECONDARY_SCL_IO,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+    };
+    const i2c_device_config_t dev_config = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = MPU6050_ADDR,
+        .scl_speed_hz = I2C_SPEED_FAST_HZ,
+    };
+    i2c_master_bus_handle_t bus;
+    i2c_master_dev_handle_t dev;
+
+    ESP_ERROR_CHECK(mpu6050_emu_attach(I2C_SECONDARY_NUM));
+    ESP_ERROR_CHECK(i2c_new_master_bus(&bus_config, &bus));
+    ESP_ERROR_CHECK(i2c_master_bus_add_device(bus, &dev_config, &dev));
+
+    const uint8_t reg = MPU6050_ACCEL_XOUT_H;
+    uint8_t buffer[14];
+    uint32_t errors = 0;
+    i2c_emu_stats_t before, after;
+    i2c_emu_get_stats(&before);
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < HOST_TEST_DIRECT_TRANSACTIONS; i++) {
+        if (i2c_master_transmit_receive(dev, &reg, 1, buffer, sizeof(buffer), MPU6050_TIMEOUT_MS) != ESP_OK) {
+            errors++;
+        }
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+    i2c_emu_get_stats(&after);
+
+    uint32_t transactions = after.transactions - before.transactions;
+    ESP_LOGI(TAG, "EMULADOR DIRETO: %lu TRANSACOES EM %lld MS, %.0f TRANSACOES/S", (unsigned long)transactions,
+             (long long)(elapsed / 1000), host_test_rate(transactions, elapsed));
+    host_test_check("leituras diretas sem erro", errors == 0);
+
+    i2c_master_bus_rm_device(dev);
+    i2c_del_master_bus(bus);
+    i2c_emu_detach(I2C_SECONDARY_NUM, MPU6050_ADDR);
+}
+
+// O mesmo laco do driver, mpu6050_read_all, passando pelo arbitro e pelas estatisticas
+static void host_test_arbiter_bench(void) {
+    mpu6050_data_t data;
+    uint32_t errors = 0;
+    i2c_emu_stats_t before, after;
+    i2c_emu_get_stats(&before);
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < HOST_TEST_ARBITER_READS; i++) {
+        if (mpu6050_read_all(&data) != ESP_OK) {
+            errors++;
+        }
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+    i2c_emu_get_stats(&after);
+
+    uint32_t transactions = after.transactions - before.transactions;
+    ESP_LOGI(TAG, "PELO ARBITRO: %lu TRANSACOES EM %lld MS, %.0f TRANSACOES/S", (unsigned long)transactions,
+             (long long)(elapsed / 1000), host_test_rate(transactions, elapsed));
+    host_test_check("mpu6050_read_all sem erro", errors == 0);
+    host_test_check("peca parada le 1 g em Z", data.accel_x == 0 && data.accel_z == 16384);
+}
+
+// NACKs seguidos devem levar o dispositivo para a velocidade segura, e as leituras
+// seguintes voltam a funcionar nela
+static void host_test_nack_fallback(void) {
+    mpu6050_data_t data;
+    int failed = 0;
+
+    i2c_emu_inject_nack(MPU6050_ADDR, I2C_FALLBACK_ERROR_COUNT);
+    for (int i = 0; i < I2C_FALLBACK_ERROR_COUNT; i++) {
+        if (mpu6050_read_all(&data) == ESP_ERR_INVALID_RESPONSE) {
+            failed++;
+        }
+    }
+    host_test_check("NACKs injetados chegam como erro", failed == I2C_FALLBACK_ERROR_COUNT);
+    host_test_check("fallback para a velocidade segura", i2c_get_device_speed(MPU6050_ADDR) == I2C_SPEED_SAFE_HZ);
+    host_test_check("leitura depois do fallback", mpu6050_read_all(&data) == ESP_OK);
+}
+
+// Trava o barramento e espera a tarefa de saude recuperar e a peca voltar a responder.
+// No fim espera o reinit da peca terminar, senao a proxima falha o pega no meio.
+static bool host_test_stuck_bus(i2c_emu_stuck_t stuck) {
+    mpu6050_data_t data;
+    uint32_t recoveries = i2c_get_recovery_count();
+
+    i2c_emu_stick_bus(I2C_MASTER_NUM, stuck);
+    if (mpu6050_read_all(&data) != ESP_ERR_TIMEOUT) {
+        return false;
+    }
+
+    int64_t deadline = esp_timer_get_time() + HOST_TEST_RECOVERY_TIMEOUT_MS * 1000LL;
+    while (esp_timer_get_time() < deadline) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        if (i2c_get_recovery_count() > recoveries && mpu6050_read_all(&data) == ESP_OK) {
+            vTaskDelay(pdMS_TO_TICKS(HOST_TEST_REINIT_SETTLE_MS));
+            return true;
+        }
+    }
+    return false;
+}
+
+// SCL em curto: a primeira recuperacao falha e o barramento fica recusando transacoes;
+// depois que a falha some, a tarefa de saude tenta de novo sozinha
+static void host_test_failed_recovery(void) {
+    mpu6050_data_t data;
+    uint32_t recoveries = i2c_get_recovery_count();
+
+    i2c_emu_stick_bus(I2C_MASTER_NUM, I2C_EMU_STUCK_SCL);
+    host_test_check("SCL preso chega como timeout", mpu6050_read_all(&data) == ESP_ERR_TIMEOUT);
+
+    int64_t deadline = esp_timer_get_time() + HOST_TEST_RECOVERY_TIMEOUT_MS * 1000LL;
+    while (i2c_get_recovery_count() == recoveries && esp_timer_get_time() < deadline) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    host_test_check("primeira recuperacao tentada", i2c_get_recovery_count() > recoveries);
+    host_test_check("barramento inativo depois da falha", !i2c_check_bus_active());
+    host_test_check("transacao recusada na hora", mpu6050_read_all(&data) == ESP_ERR_INVALID_STATE);
+
+    i2c_emu_stick_bus(I2C_MASTER_NUM, I2C_EMU_STUCK_NONE);
+    recoveries = i2c_get_recovery_count();
+    bool recovered = false;
+    deadline = esp_timer_get_time() + HOST_TEST_RECOVERY_TIMEOUT_MS * 1000LL;
+    while (!recovered && esp_timer_get_time() < deadline) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        recovered = i2c_get_recovery_count() > recoveries && mpu6050_read_all(&data) == ESP_OK;
+    }
+    host_test_check("nova tentativa recupera o barramento", recovered);
+    vTaskDelay(pdMS_TO_TICKS(HOST_TEST_REINIT_SETTLE_MS));
+}
+
+// FIFO no relogio virtual: leitura normal, transbordo detectado pelo INT_STATUS e volta
+// ao alinhamento depois do reset
+static void host_test_fifo(void) {
+    static mpu6050_data_t samples[MPU6050_FIFO_SIZE / 12];
+    const int64_t period_us = 1000000 / mpu6050_get_sample_rate_hz();
+    size_t count;
+
+    host_test_check("mpu6050_fifo_enable", mpu6050_fifo_enable(MPU6050_FIFO_ACCEL | MPU6050_FIFO_GYRO) == ESP_OK);
+    uint32_t overflows = mpu6050_get_fifo_overflows();
+
+    i2c_emu_advance_us(HOST_TEST_FIFO_SAMPLES * period_us);
+    esp_err_t ret = mpu6050_fifo_read(samples, HOST_TEST_FIFO_SAMPLES * 2, &count);
+    host_test_check("FIFO lida sem transbordo", ret == ESP_OK && mpu6050_get_fifo_overflows() == overflows);
+    host_test_check("amostras da FIFO", count >= HOST_TEST_FIFO_SAMPLES && samples[0].accel_z == 16384);
+
+    // 1024 bytes guardam 85 amostras de 12 bytes
+    i2c_emu_advance_us((MPU6050_FIFO_SIZE / 12 + HOST_TEST_FIFO_SAMPLES) * period_us);
+    ret = mpu6050_fifo_read(samples, MPU6050_FIFO_SIZE / 12, &count);
+    host_test_check("transbordo detectado", ret == ESP_ERR_INVALID_STATE && count == 0 &&
+                                                mpu6050_get_fifo_overflows() == overflows + 1);
+
+    i2c_emu_advance_us(HOST_TEST_FIFO_SAMPLES * period_us);
+    ret = mpu6050_fifo_read(samples, HOST_TEST_FIFO_SAMPLES * 2, &count);
+    host_test_check("FIFO realinhada depois do reset", ret == ESP_OK && count >= HOST_TEST_FIFO_SAMPLES &&
+                                                           samples[count - 1].accel_z == 16384 &&
+                                                           samples[count - 1].gyro_x == 0);
+
+    host_test_check("mpu6050_fifo_disable", mpu6050_fifo_disable() == ESP_OK);
+}
+
+// Uma escrita recusada no meio da troca de perfil devolve o perfil anterior para a
+// struct e para a peca
+static void host_test_profile_rollback(void) {
+    const mpu6050_config_t previous = *mpu6050_get_config();
+
+    i2c_emu_inject_nack(MPU6050_ADDR, 1);
+    host_test_check("troca de perfil falha com NACK", mpu6050_set_config(&MPU6050_PROFILE_HIGH_G) != ESP_OK);
+    const mpu6050_config_t *config = mpu6050_get_config();
+    host_test_check("perfil anterior de volta na struct",
+                    config->sample_rate_hz == previous.sample_rate_hz && config->accel_range == previous.accel_range &&
+                        config->gyro_range == previous.gyro_range && config->dlpf == previous.dlpf);
+    host_test_check("perfil anterior de volta na peca",
+                    mpu6050_emu_peek(MPU6050_CONFIG) == previous.dlpf &&
+                        mpu6050_emu_peek(MPU6050_ACCEL_CONFIG) == previous.accel_range << 3 &&
+                        mpu6050_emu_peek(MPU6050_GYRO_CONFIG) == previous.gyro_range << 3);
+}
+
+// Peca parada com X contando os ms, para cada amostra gravada ser diferente das vizinhas
+static void host_test_counting_source(int64_t timestamp_us, mpu6050_data_t *out, void *arg) {
+    *out = (mpu6050_data_t){
+        .accel_x = (int16_t)((timestamp_us / 1000) & 0x3FFF),
+        .accel_z = 16384,
+    };
+}
+
+// Servico de sensor com amostragem periodica (o INT nao e emulado), troca de perfil e
+// gravacao, agora no relogio real para as amostras sairem no ritmo da taxa
+static void host_test_sensor(void) {
+    i2c_emu_set_realtime(true);
+
+    esp_err_t nvs_ret = nvs_flash_init();
+    if (nvs_ret != ESP_OK) {
+        ESP_LOGW(TAG, "NVS INDISPONIVEL (%s), SEGUINDO SEM CALIBRACAO", esp_err_to_name(nvs_ret));
+    }
+
+    host_test_check("sensor_service_start", sensor_service_start() == ESP_OK);
+    vTaskDelay(pdMS_TO_TICKS(HOST_TEST_SAMPLING_MS));
+    sensor_sample_t sample;
+    host_test_check("amostras publicadas", sensor_get_latest(&sample) && sensor_get_sample_count() > 0);
+    host_test_check("amostra em g", sample.accel_g[2] > 0.99f && sample.accel_g[2] < 1.01f);
+
+    host_test_check("sensor_set_profile", sensor_set_profile(&MPU6050_PROFILE_SMOOTH) == ESP_OK);
+    host_test_check("perfil gravado na peca", mpu6050_emu_peek(MPU6050_CONFIG) == MPU6050_PROFILE_SMOOTH.dlpf);
+
+    remove(HOST_TEST_RECORD_PATH);
+    mpu6050_emu_set_source(host_test_counting_source, NULL);
+    host_test_check("sensor_record_start", sensor_record_start(HOST_TEST_RECORD_PATH) == ESP_OK);
+    host_test_check("perfil travado durante a gravacao",
+                    sensor_set_profile(&MPU6050_PROFILE_BALANCED) == ESP_ERR_INVALID_STATE);
+    vTaskDelay(pdMS_TO_TICKS(HOST_TEST_RECORD_MS));
+    host_test_check("sensor_record_stop", sensor_record_stop() == ESP_OK);
+    mpu6050_emu_set_source(NULL, NULL);
+
+    record_reader_t reader;
+    uint32_t records = 0;
+    mpu6050_data_t last = {0};
+    if (record_reader_open(&reader, HOST_TEST_RECORD_PATH) == ESP_OK) {
+        mpu6050_data_t data;
+        int64_t timestamp_us;
+        while (record_read(&reader, &data, &timestamp_us, NULL) == ESP_OK) {
+            last = data;
+            records++;
+        }
+        host_test_check("cabecalho com a taxa do perfil", reader.info.sample_rate_hz == MPU6050_PROFILE_SMOOTH.sample_rate_hz);
+        record_reader_close(&reader);
+    }
+    ESP_LOGI(TAG, "GRAVACAO: %lu AMOSTRAS EM %d MS", (unsigned long)records, HOST_TEST_RECORD_MS);
+    host_test_check("gravacao lida de volta", records > 0);
+
+    record_writer_t writer;
+    const record_info_t other_rate = {
+        .sample_rate_hz = MPU6050_PROFILE_BALANCED.sample_rate_hz,
+        .dlpf = MPU6050_PROFILE_SMOOTH.dlpf,
+        .accel_range = MPU6050_PROFILE_SMOOTH.accel_range,
+        .gyro_range = MPU6050_PROFILE_SMOOTH.gyro_range,
+    };
+    host_test_check("anexo com outra taxa recusado",
+                    record_writer_open(&writer, HOST_TEST_RECORD_PATH, &other_rate) == ESP_ERR_INVALID_ARG);
+
+    // Replay do mesmo arquivo, o mais rapido possivel, no lugar da peca
+    host_test_check("replay recusado com a peca amostrando",
+                    sensor_service_start_replay(HOST_TEST_RECORD_PATH, false) == ESP_ERR_INVALID_STATE);
+    host_test_check("sensor_service_stop", sensor_service_stop() == ESP_OK);
+    uint32_t published = sensor_get_sample_count();
+    host_test_check("sensor_service_start_replay", sensor_service_start_replay(HOST_TEST_RECORD_PATH, false) == ESP_OK);
+
+    int64_t deadline = esp_timer_get_time() + HOST_TEST_REPLAY_TIMEOUT_MS * 1000LL;
+    while (sensor_get_sample_count() - published < records && esp_timer_get_time() < deadline) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    host_test_check("replay publicou todas as amostras", sensor_get_sample_count() - published == records);
+    host_test_check("ultima amostra publicada e a ultima gravada",
+                    sensor_get_latest(&sample) && memcmp(&sample.raw, &last, sizeof(last)) == 0 && last.accel_x != 0);
+    host_test_check("perfil travado no replay", sensor_set_profile(&MPU6050_PROFILE_BALANCED) == ESP_ERR_INVALID_STATE);
+}
+
+void app_main(void) {
+    ESP_LOGI(TAG, "TESTE EM HOST DO I2CLIB E MPU6050 SOBRE O EMULADOR");
+
+    host_test_direct_bench();
+
+    ESP_ERROR_CHECK(mpu6050_emu_attach(I2C_MASTER_NUM));
+    ESP_ERROR_CHECK(i2c_init());
+    host_test_check("mpu6050_init", mpu6050_init() == ESP_OK);
+    host_test_check("negociado em fast mode", i2c_get_device_speed(MPU6050_ADDR) == I2C_SPEED_FAST_HZ);
+
+    host_test_arbiter_bench();
+    host_test_nack_fallback();
+    host_test_fifo();
+    host_test_profile_rollback();
+    host_test_check("recuperacao com SDA preso", host_test_stuck_bus(I2C_EMU_STUCK_SDA));
+    host_test_check("recuperacao com SDA preso ate os pulsos manuais", host_test_stuck_bus(I2C_EMU_STUCK_SDA_HARD));
+    host_test_failed_recovery();
+
+    i2c_emu_stats_t stats;
+    i2c_emu_get_stats(&stats);
+    ESP_LOGI(TAG, "BARRAMENTO EMULADO: %lu TRANSACOES, %lu NACKS, %lu TIMEOUTS, %lu RECUPERACOES",
+             (unsigned long)stats.transactions, (unsigned long)stats.nacks, (unsigned long)stats.timeouts,
+             (unsigned long)i2c_get_recovery_count());
+
+    host_test_sensor();
+
+    ESP_LOGI(TAG, "FIM: %d FALHAS", host_test_failures);
+    exit(host_test_failures == 0 ? 0 : 1);
+}
@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "mpu6050.h"
+#include "ssd1306.h"
+#include "bench.h"
+
+static const char *TAG = "BENCH";
+
+// Impedem que o compilador descarte os lacos de atan2 medidos
+volatile float bench_angle_sink;
+volatile int32_t bench_angle_q16_sink;
+
+// Cena parecida com a de um jogo: placar, bola e raquete
+static void bench_render_scene(int frame) {
+    char text[20];
+
+    ssd1306_clear_buffer();
+    snprintf(text, sizeof(text), "FRAME:%d", frame);
+    ssd1306_draw_string(5, 5, text);
+    ssd1306_draw_circle(20 + frame % 88, 32, 3, true);
+    ssd1306_draw_rect(frame % 108, 58, 20, 4, true);
+}
+
+static void bench_log(const char *name, int64_t total_us, int64_t max_us) {
+    ESP_LOGI(TAG, "%s: MEDIA %lld US POR FRAME, MAXIMO %lld US", name,
+             (long long)(total_us / BENCH_FRAMES), (long long)max_us);
+}
+
+// Le o sensor, desenha e apresenta, esperando a leitura antes de desenhar
+static void bench_frame_sync(void) {
+    int64_t total_us = 0;
+    int64_t max_us = 0;
+
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        int64_t start = esp_timer_get_time();
+        mpu6050_data_t data;
+        mpu6050_read_all(&data);
+        bench_render_scene(frame);
+        ssd1306_present();
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        total_us += elapsed;
+        if (elapsed > max_us) max_us = elapsed;
+        ssd1306_present_blocking();
+    }
+    bench_log("SINCRONO", total_us, max_us);
+}
+
+// Dispara a leitura, desenha enquanto ela corre no barramento e so entao coleta
+static void bench_frame_async(void) {
+    int64_t total_us = 0;
+    int64_t max_us = 0;
+
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        int64_t start = esp_timer_get_time();
+        mpu6050_read_op_t op = {0};
+        mpu6050_data_t data;
+        if (mpu6050_read_all_async(&op) == ESP_OK) {
+            bench_render_scene(frame);
+            mpu6050_read_all_collect(&op, &data, portMAX_DELAY);
+        } else {
+            bench_render_scene(frame);
+        }
+        ssd1306_present();
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        total_us += elapsed;
+        if (elapsed > max_us) max_us = elapsed;
+        ssd1306_present_blocking();
+    }
+    bench_log("ASSINCRONO", total_us, max_us);
+}
+
+// Latencia de leitura do sensor com um quadro completo indo para o display. Com os dois
+// no mesmo barramento a leitura espera no maximo um bloco; em barramentos separados, nada.
+static void bench_read_during_flush(void) {
+    int64_t total_us = 0;
+    int64_t max_us = 0;
+
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        bench_render_scene(frame);
+        ssd1306_force_full_refresh();
+        ssd1306_present();
+
+        int64_t start = esp_timer_get_time();
+        mpu6050_data_t data;
+        mpu6050_read_all(&data);
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        total_us += elapsed;
+        if (elapsed > max_us) max_us = elapsed;
+        ssd1306_present_blocking();
+    }
+
+    bool split = i2c_get_device_bus(MPU6050_ADDR) != i2c_get_device_bus(SSD1306_I2C_ADDR);
+    ESP_LOGI(TAG, "LEITURA DO MPU6050 DURANTE ENVIO DE QUADRO COMPLETO (%s): MEDIA %lld US, MAXIMO %lld US",
+             split ? "BARRAMENTOS SEPARADOS" : "BARRAMENTO UNICO",
+             (long long)(total_us / BENCH_FRAMES), (long long)max_us);
+}
+
+// Conversao antiga, com as sete divisoes em float, como referencia
+static void bench_convert_float_ref(const mpu6050_data_t *raw, float *accel_g, float *gyro_dps, float *temp_c) {
+    accel_g[0] = (float)raw->accel_x / 16384.0f;
+    accel_g[1] = (float)raw->accel_y / 16384.0f;
+    accel_g[2] = (float)raw->accel_z / 16384.0f;
+    gyro_dps[0] = (float)raw->gyro_x / 131.0f;
+    gyro_dps[1] = (float)raw->gyro_y / 131.0f;
+    gyro_dps[2] = (float)raw->gyro_z / 131.0f;
+    *temp_c = (float)raw->temp / 340.0f + 36.53f;
+}
+
+static void bench_log_cycles(const char *name, uint32_t cycles) {
+    ESP_LOGI(TAG, "%s: %lu CICLOS POR AMOSTRA", name, (unsigned long)(cycles / BENCH_CONVERT_SAMPLES));
+}
+
+// Ciclos por amostra do caminho em float contra o Q16 em lote, e o erro maximo de cada um
+static void bench_convert(void) {
+    static mpu6050_data_t raw[BENCH_CONVERT_SAMPLES];
+    static mpu6050_q16_data_t fixed[BENCH_CONVERT_SAMPLES];
+    static float accel_g[BENCH_CONVERT_SAMPLES][3];
+    static float gyro_dps[BENCH_CONVERT_SAMPLES][3];
+    static float temp_c[BENCH_CONVERT_SAMPLES];
+
+    for (int i = 0; i < BENCH_CONVERT_SAMPLES; i++) {
+        raw[i] = (mpu6050_data_t){ rand(), rand(), rand(), rand(), rand(), rand(), rand() };
+    }
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < BENCH_CONVERT_SAMPLES; i++) {
+        bench_convert_float_ref(&raw[i], accel_g[i], gyro_dps[i], &temp_c[i]);
+    }
+    bench_log_cycles("CONVERSAO FLOAT", esp_cpu_get_cycle_count() - start);
+
+    start = esp_cpu_get_cycle_count();
+    mpu6050_convert_q16(raw, fixed, BENCH_CONVERT_SAMPLES);
+    bench_log_cycles("CONVERSAO Q16 EM LOTE", esp_cpu_get_cycle_count() - start);
+
+    start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < BENCH_CONVERT_SAMPLES; i++) {
+        mpu6050_convert_data(&raw[i], accel_g[i], gyro_dps[i], &temp_c[i]);
+    }
+    bench_log_cycles("CONVERSAO FLOAT SOBRE Q16", esp_cpu_get_cycle_count() - start);
+
+    start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < BENCH_CONVERT_SAMPLES; i++) {
+        bench_angle_sink = atan2f(accel_g[i][0], accel_g[i][1]) * 180.0f / (float)M_PI;
+    }
+    bench_log_cycles("ATAN2 LIBM", esp_cpu_get_cycle_count() - start);
+
+    start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < BENCH_CONVERT_SAMPLES; i++) {
+        bench_angle_q16_sink = mpu6050_atan2_deg_q16(fixed[i].accel_g[0], fixed[i].accel_g[1]);
+    }
+    bench_log_cycles("ATAN2 TABELA", esp_cpu_get_cycle_count() - start);
+
+    float max_gyro_err = 0, max_temp_err = 0, max_angle_err = 0;
+    for (int i = 0; i < BENCH_CONVERT_SAMPLES; i++) {
+        float ref_accel[3], ref_gyro[3], ref_temp;
+        bench_convert_float_ref(&raw[i], ref_accel, ref_gyro, &ref_temp);
+        max_gyro_err = fmaxf(max_gyro_err, fabsf(MPU6050_Q16_TO_FLOAT(fixed[i].gyro_dps[0]) - ref_gyro[0]));
+        max_temp_err = fmaxf(max_temp_err, fabsf(MPU6050_Q16_TO_FLOAT(fixed[i].temp_c) - ref_temp));
+
+        float ref_angle = atan2f(ref_accel[0], ref_accel[1]) * 180.0f / (float)M_PI;
+        float angle_err = fabsf(MPU6050_Q16_TO_FLOAT(mpu6050_atan2_deg_q16(fixed[i].accel_g[0], fixed[i].accel_g[1])) - ref_angle);
+        max_angle_err = fmaxf(max_angle_err, angle_err > 180.0f ? 360.0f - angle_err : angle_err);
+    }
+    ESP_LOGI(TAG, "ERRO MAXIMO Q16: GIRO %.5f DPS, TEMPERATURA %.5f C, ANGULO %.5f GRAUS",
+             max_gyro_err, max_temp_err, max_angle_err);
+}
+
+void bench_run_all(void) {
+    ESP_LOGI(TAG, "CONVERSAO DO MPU6050 (%d AMOSTRAS)", BENCH_CONVERT_SAMPLES);
+    bench_convert();
+
+    ESP_LOGI(TAG, "TEMPO DE FRAME COM LEITURA DO MPU6050 (%d FRAMES)", BENCH_FRAMES);
+    bench_frame_sync();
+    bench_frame_async();
+    bench_read_during_flush();
+}
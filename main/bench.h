@@ -0,0 +1,9 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#define BENCH_FRAMES 200
+#define BENCH_CONVERT_SAMPLES 256
+
+void bench_run_all(void);
+
+#endif
@@ -0,0 +1,21 @@
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+#include "heap_stats.h"
+
+static volatile uint32_t heap_stats_alloc_count = 0;
+
+#if CONFIG_HEAP_USE_HOOKS
+// O heap so aceita um par de ganchos no firmware inteiro, entao eles ficam aqui na
+// aplicacao e nao em um driver. Chamado a cada alocacao, de qualquer tarefa ou ISR.
+void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+    __atomic_fetch_add(&heap_stats_alloc_count, 1, __ATOMIC_RELAXED);
+}
+
+void IRAM_ATTR esp_heap_trace_free_hook(void *ptr) {
+}
+#endif
+
+uint32_t heap_stats_get_alloc_count(void) {
+    return heap_stats_alloc_count;
+}
@@ -0,0 +1,9 @@
+#ifndef HEAP_STATS_H
+#define HEAP_STATS_H
+
+#include <stdint.h>
+
+// Alocacoes bem-sucedidas no heap desde o boot, de qualquer componente
+uint32_t heap_stats_get_alloc_count(void);
+
+#endif
@@ -8,6 +8,8 @@
 #include "button.h"
 #include "i2clib.h"
 #include "mpu6050.h"
+#include "sensor.h"
+#include "nvs_flash.h"
 #include "ssd1306.h"
 #include "buzzer.h"
 #include "menu.h"
@@ -15,6 +17,8 @@
 #include "tilt_maze.h"
 #include "snake.h"
 #include "pong.h"
+#include "bench.h"
+#include "heap_stats.h"
 
 static const char *TAG = "MAIN";
 
@@ -25,19 +29,37 @@ void app_main(void) {
     ESP_LOGI(TAG, "INICIANDO SISTEMA DE JOGOS");
 
     ESP_ERROR_CHECK(i2c_init());
+
+    // Placas com o display no segundo controlador ganham um barramento so para ele;
+    // na placa atual sensor e display ficam juntos no primario
+    const i2c_bus_pins_t display_pins = {
+        .port = I2C_SECONDARY_NUM,
+        .sda_io = I2C_SECONDARY_SDA_IO,
+        .scl_io = I2C_SECONDARY_SCL_IO,
+    };
+    if (i2c_bus_detect(&display_pins, SSD1306_I2C_ADDR) &&
+        i2c_bus_init(I2C_BUS_SECONDARY, &display_pins) == ESP_OK) {
+        i2c_bind_device(SSD1306_I2C_ADDR, I2C_BUS_SECONDARY);
+    }
     vTaskDelay(200 / portTICK_PERIOD_MS);
     
-    gpio_config_t btn_config = {
-        .pin_bit_mask = (1ULL << BUTTON_1_GPIO) | (1ULL << BUTTON_2_GPIO),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = GPIO_PULLUP_ENABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE
-    };
-    ESP_ERROR_CHECK(init_buttons(&btn_config));
+    // Os botoes geram eventos de aperto, soltura, pressao longa e duplo clique na fila
+    const gpio_num_t button_gpios[] = {BUTTON_1_GPIO, BUTTON_2_GPIO};
+    for (int i = 0; i < sizeof(button_gpios) / sizeof(button_gpios[0]); i++) {
+        button_config_t btn_config = {
+            .gpio_num = button_gpios[i],
+            .pull_mode = GPIO_PULLUP_ONLY,
+            .active_low = true,
+            .debounce_time_ms = BUTTON_DEBOUNCE_TIME_MS,
+            .long_press_time_ms = BUTTON_LONG_PRESS_TIME_MS,
+            .callback = NULL
+        };
+        ESP_ERROR_CHECK(button_config_advanced(&btn_config));
+    }
 
     buzzer_init();
     ssd1306_init();
+    ESP_ERROR_CHECK(ssd1306_start_flush_task());
     menu_init();
 
     esp_err_t mpu_ret = mpu6050_init();
@@ -55,6 +77,26 @@ void app_main(void) {
         }
     }
 
+    // A calibracao do sensor fica na NVS entre um boot e outro
+    esp_err_t nvs_ret = nvs_flash_init();
+    if (nvs_ret == ESP_ERR_NVS_NO_FREE_PAGES || nvs_ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        nvs_ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(nvs_ret);
+
+    // A partir daqui os jogos leem o sensor so pelo servico, sem esperar o I2C
+    ESP_ERROR_CHECK(sensor_service_start());
+
+    ESP_LOGI(TAG, "VELOCIDADE I2C: MPU6050 %lu HZ (BARRAMENTO %d), SSD1306 %lu HZ (BARRAMENTO %d)",
+             (unsigned long)i2c_get_device_speed(MPU6050_ADDR), i2c_get_device_bus(MPU6050_ADDR),
+             (unsigned long)i2c_get_device_speed(SSD1306_I2C_ADDR), i2c_get_device_bus(SSD1306_I2C_ADDR));
+
+    // Os dois botoes apertados no boot rodam os benchmarks antes do menu
+    if (gpio_get_level(BUTTON_1_GPIO) == 0 && gpio_get_level(BUTTON_2_GPIO) == 0) {
+        bench_run_all();
+    }
+
     srand(time(NULL));
 
     play_tone(800, 100);
@@ -71,6 +113,10 @@ void app_main(void) {
 
         if (menu_option_selected()) {
             current_option = menu_get_selected_option();
+            ssd1306_reset_stats();
+            i2c_reset_queue_stats();
+            i2c_reset_device_stats();
+            uint32_t heap_allocs_before = heap_stats_get_alloc_count();
 
             switch(current_option) {
                 case MENU_OPTION_DODGE:
@@ -93,6 +139,30 @@ void app_main(void) {
                     break;
             }
 
+            ssd1306_stats_t display_stats;
+            ssd1306_get_stats(&display_stats);
+            ESP_LOGI(TAG, "DISPLAY: %lu BYTES EM %lu TRANSACOES, %lu FRAMES, %lu DESCARTADOS",
+                     (unsigned long)display_stats.bytes_sent, (unsigned long)display_stats.transactions,
+                     (unsigned long)display_stats.frames, (unsigned long)display_stats.frames_dropped);
+            for (int prio = 0; prio < I2C_PRIORITY_COUNT; prio++) {
+                i2c_queue_stats_t queue_stats;
+                i2c_get_queue_stats(prio, &queue_stats);
+                ESP_LOGI(TAG, "FILA I2C %s: %lu TRANSACOES, %lu BLOCOS, ESPERA MEDIA %lu US, MAXIMA %lu US",
+                         prio == I2C_PRIORITY_HIGH ? "ALTA" : "BAIXA",
+                         (unsigned long)queue_stats.transactions, (unsigned long)queue_stats.chunks,
+                         (unsigned long)(queue_stats.transactions ? queue_stats.total_wait_us / queue_stats.transactions : 0),
+                         (unsigned long)queue_stats.max_wait_us);
+            }
+            i2c_dump_stats();
+            ESP_LOGI(TAG, "RECUPERACOES DO BARRAMENTO I2C: %lu", (unsigned long)i2c_get_recovery_count());
+            ring_stats_t button_stats;
+            button_get_event_stats(&button_stats);
+            ESP_LOGI(TAG, "EVENTOS DE BOTAO: %lu, %lu PERDIDOS, OCUPACAO MAXIMA %lu",
+                     (unsigned long)button_stats.pushed, (unsigned long)button_stats.dropped,
+                     (unsigned long)button_stats.high_water);
+            ESP_LOGI(TAG, "ALOCACOES NO HEAP DURANTE O JOGO: %lu",
+                     (unsigned long)(heap_stats_get_alloc_count() - heap_allocs_before));
+
             ssd1306_clear_buffer();
         }
 